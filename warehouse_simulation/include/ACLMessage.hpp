@@ -1,66 +1,146 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <iostream>
+#include <type_traits>
+#include <variant>
 
 namespace acl {
 
-enum class Performative {
+// Index handed out by AgentRegistry at registration. Broadcast and multicast
+// messages carry NO_AGENT as their receiver.
+using AgentId = uint32_t;
+constexpr AgentId NO_AGENT = UINT32_MAX;
+
+// Multicast group, created through AgentRegistry::createGroup
+using GroupId = uint32_t;
+
+// Unique per sender for the life of a simulation; 0 = none
+using ConversationId = uint64_t;
+
+enum class Performative : uint8_t {
     REQUEST,
     INFORM,
     QUERY_REF,
+    CFP,
+    PROPOSE,
+    REFUSE,
+    ACCEPT_PROPOSAL,
+    REJECT_PROPOSAL,
     // Agrega más según necesites
 };
 
-inline std::string performativeToString(Performative p) {
+enum class Language : uint8_t {
+    SL,
+};
+
+enum class Ontology : uint8_t {
+    WAREHOUSE,
+};
+
+enum class Protocol : uint8_t {
+    FIPA_CONTRACT_NET,
+};
+
+inline const char* performativeName(Performative p) {
     switch(p) {
         case Performative::REQUEST: return "REQUEST";
         case Performative::INFORM: return "INFORM";
         case Performative::QUERY_REF: return "QUERY_REF";
+        case Performative::CFP: return "CFP";
+        case Performative::PROPOSE: return "PROPOSE";
+        case Performative::REFUSE: return "REFUSE";
+        case Performative::ACCEPT_PROPOSAL: return "ACCEPT_PROPOSAL";
+        case Performative::REJECT_PROPOSAL: return "REJECT_PROPOSAL";
         default: return "UNKNOWN";
     }
 }
 
+inline const char* languageName(Language l) {
+    switch (l) {
+        case Language::SL: return "SL";
+    }
+    return "UNKNOWN";
+}
+
+inline const char* ontologyName(Ontology o) {
+    switch (o) {
+        case Ontology::WAREHOUSE: return "warehouse-ontology";
+    }
+    return "UNKNOWN";
+}
+
+inline const char* protocolName(Protocol p) {
+    switch (p) {
+        case Protocol::FIPA_CONTRACT_NET: return "fipa-contract-net";
+    }
+    return "UNKNOWN";
+}
+
+// Message contents. Each is a plain value, so a message never owns heap memory.
+struct BoxQuery {
+    int x, y;           // "is the box at (x, y) free?"
+};
+
+struct Availability {
+    bool available;     // answer to a BoxQuery
+};
+
+using Content = std::variant<std::monostate, BoxQuery, Availability>;
+
+// Same SL text the messages used to carry as strings
+inline std::string contentToString(const Content& content) {
+    if (const BoxQuery* q = std::get_if<BoxQuery>(&content))
+        return "available? box(" + std::to_string(q->x) + "," + std::to_string(q->y) + ")";
+    if (const Availability* a = std::get_if<Availability>(&content))
+        return a->available ? "YES" : "NO";
+    return "";
+}
+
 class ACLMessage {
 public:
     Performative performative;
-    std::string sender;
-    std::string receiver;
-    std::string content;
-    std::string language;
-    std::string ontology;
-    std::string protocol;
-    std::string conversationId;
+    Language language;
+    Ontology ontology;
+    Protocol protocol;
+    AgentId sender;
+    AgentId receiver;
+    ConversationId conversationId;
+    Content content;
 
     ACLMessage(
         Performative perf,
-        const std::string& sndr,
-        const std::string& rcvr,
-        const std::string& cont,
-        const std::string& lang,
-        const std::string& onto,
-        const std::string& proto,
-        const std::string& convId
+        AgentId sndr,
+        AgentId rcvr,
+        const Content& cont,
+        Language lang,
+        Ontology onto,
+        Protocol proto,
+        ConversationId convId
     ) : performative(perf),
-        sender(sndr),
-        receiver(rcvr),
-        content(cont),
         language(lang),
         ontology(onto),
         protocol(proto),
-        conversationId(convId)
+        sender(sndr),
+        receiver(rcvr),
+        conversationId(convId),
+        content(cont)
     {}
 
     void print() const {
         std::cout << "ACLMessage:\n"
-                  << "  Performative: " << performativeToString(performative) << "\n"
+                  << "  Performative: " << performativeName(performative) << "\n"
                   << "  From: " << sender << "\n"
                   << "  To: " << receiver << "\n"
-                  << "  Content: " << content << "\n"
-                  << "  Language: " << language << "\n"
-                  << "  Ontology: " << ontology << "\n"
-                  << "  Protocol: " << protocol << "\n"
+                  << "  Content: " << contentToString(content) << "\n"
+                  << "  Language: " << languageName(language) << "\n"
+                  << "  Ontology: " << ontologyName(ontology) << "\n"
+                  << "  Protocol: " << protocolName(protocol) << "\n"
                   << "  ConversationId: " << conversationId << "\n";
     }
 };
 
-} // namespace acl
\ No newline at end of file
+// Messages are copied into outboxes and inboxes every tick
+static_assert(std::is_trivially_copyable<ACLMessage>::value, "ACLMessage must stay a plain value");
+
+} // namespace acl
@@ -2,26 +2,58 @@
 #define AGENT_HPP
 
 #include <string>
+#include <vector>
 
 #include "ACLMessage.hpp"
+#include "ContractNet.hpp"
+
+class AgentRegistry;
 
 class Agent {
 public:
-    Agent(const std::string& name);
+    Agent(const std::string& name, AgentRegistry& registry);
     virtual void receive(const acl::ACLMessage& msg) = 0;
     virtual void handleResponse(const acl::ACLMessage& msg) = 0;
 
-    std::string generateUniqueConversationId();
-    void sendRequest(const std::string& receiver, const std::string& content, const std::string& convId);
-    bool hasResponseArrived(const std::string& conversationId);
+    void sendRequest(acl::AgentId receiver, const acl::Content& content, acl::ConversationId convId);
+
+    const std::string& getName() const { return name; }
+    acl::AgentId getId() const { return id; }
+
+    // Queues the message; it reaches the receiver in the next delivery phase
+    void send(acl::AgentId receiver, const acl::ACLMessage& msg);
+
+    // One message for every other agent, or every other member of `group`.
+    // It is stored once and shared by all receivers. Both return the number
+    // of receivers as of now.
+    int broadcast(const acl::ACLMessage& msg);
+    int multicast(acl::GroupId group, const acl::ACLMessage& msg);
 
-    std::string getName() const { return name; }
-    void send(const std::string& receiverName, const acl::ACLMessage& msg);
+    // Called by AgentRegistry::deliverMessages: hands every message that was
+    // in the inbox at the start of the phase to receive(). The inbox holds
+    // positions in `mail`, the registry's copy of this phase's messages.
+    void processInbox(const std::vector<acl::ACLMessage>& mail);
 
 protected:
     std::string name;
-    std::unordered_map<std::string, bool> pendingRequests;
-    std::unordered_map<std::string, int> waitingForResponses;
+    acl::AgentId id;
+    AgentRegistry& registry;
+    acl::ContractNet negotiations;
+
+private:
+    friend class AgentRegistry;
+
+    enum class Audience : uint8_t { ONE, ALL, GROUP };
+
+    struct Envelope {
+        Audience audience;
+        uint32_t target;        // AgentId for ONE, GroupId for GROUP
+        acl::ACLMessage msg;
+    };
+
+    std::vector<Envelope> outbox;
+    std::vector<uint32_t> inbox;
+    std::vector<uint32_t> processing;
 };
 
 #endif
\ No newline at end of file
@@ -1,25 +1,123 @@
 #ifndef AGENTREGISTRY_HPP
 #define AGENTREGISTRY_HPP
 
+#include <algorithm>
 #include <unordered_map>
+#include <vector>
 #include "Agent.hpp"
+#include "Log.hpp"
+#include "Metrics.hpp"
 
+// Agent directory for one simulation. Each SimulationContext owns its own
+// registry, so agents of different runs never see each other. Agents get a
+// dense id at registration; messages address each other by that id and the
+// name lookup is only for callers that start from a name.
+//
+// Messages are not delivered when sent. Once per tick deliverMessages() moves
+// every outbox into this phase's mail (in registration order, so the result
+// does not depend on who sent first), gives each receiver the mail slot in
+// its inbox and then lets each agent process its inbox. A broadcast or
+// multicast is stored once however many agents receive it. Anything sent
+// while processing goes out on the next tick.
 class AgentRegistry {
 public:
-    static void registerAgent(const std::string& name, Agent* agent) {
-        agents()[name] = agent;
+    // Message counts go to `metrics` when given
+    explicit AgentRegistry(Metrics* metrics = nullptr) : metrics(metrics) {}
+
+    // Re-registering a name hands its id to the new agent
+    acl::AgentId registerAgent(const std::string& name, Agent* agent) {
+        auto [it, inserted] = ids.emplace(name, static_cast<acl::AgentId>(order.size()));
+        if (inserted)
+            order.push_back(agent);
+        else
+            order[it->second] = agent;
+        return it->second;
     }
 
-    static Agent* getAgent(const std::string& name) {
-        auto it = agents().find(name);
-        return (it != agents().end()) ? it->second : nullptr;
+    Agent* getAgent(acl::AgentId id) const {
+        return id < order.size() ? order[id] : nullptr;
     }
 
-private:
-    static std::unordered_map<std::string, Agent*>& agents() {
-        static std::unordered_map<std::string, Agent*> instance;
-        return instance;
+    Agent* getAgent(const std::string& name) const {
+        auto it = ids.find(name);
+        return (it != ids.end()) ? order[it->second] : nullptr;
+    }
+
+    size_t agentCount() const { return order.size(); }
+
+    // Multicast groups. Membership is read when the message is delivered.
+    acl::GroupId createGroup() {
+        groups.emplace_back();
+        return static_cast<acl::GroupId>(groups.size() - 1);
+    }
+
+    void joinGroup(acl::GroupId group, acl::AgentId agent) {
+        std::vector<acl::AgentId>& members = groups[group];
+        if (std::find(members.begin(), members.end(), agent) == members.end())
+            members.push_back(agent);
+    }
+
+    void leaveGroup(acl::GroupId group, acl::AgentId agent) {
+        std::vector<acl::AgentId>& members = groups[group];
+        members.erase(std::remove(members.begin(), members.end(), agent), members.end());
+    }
+
+    const std::vector<acl::AgentId>& groupMembers(acl::GroupId group) const { return groups[group]; }
+
+    // Everything the last deliverMessages() handed out, in sender order
+    const std::vector<acl::ACLMessage>& deliveredMail() const { return mail; }
+
+    void deliverMessages() {
+        mail.clear();
+        for (Agent* sender : order) {
+            for (const auto& envelope : sender->outbox) {
+                uint32_t slot = static_cast<uint32_t>(mail.size());
+                mail.push_back(envelope.msg);
+                size_t receivers = 0;
+
+                switch (envelope.audience) {
+                    case Agent::Audience::ONE:
+                        if (Agent* receiver = getAgent(envelope.target)) {
+                            receiver->inbox.push_back(slot);
+                            receivers++;
+                        } else {
+                            WLOG_ERROR(ACL, "agent #{} not found", envelope.target);
+                        }
+                        break;
+
+                    case Agent::Audience::ALL:
+                        for (Agent* receiver : order)
+                            if (receiver != sender) {
+                                receiver->inbox.push_back(slot);
+                                receivers++;
+                            }
+                        break;
+
+                    case Agent::Audience::GROUP:
+                        for (acl::AgentId member : groups[envelope.target])
+                            if (order[member] != sender) {
+                                order[member]->inbox.push_back(slot);
+                                receivers++;
+                            }
+                        break;
+                }
+
+                if (metrics)
+                    metrics->countMessage(envelope.msg.performative, receivers);
+            }
+            sender->outbox.clear();
+        }
+
+        for (Agent* agent : order)
+            agent->processInbox(mail);
     }
+
+private:
+    Metrics* metrics;
+    std::unordered_map<std::string, acl::AgentId> ids;
+    std::vector<Agent*> order;      // indexed by AgentId
+    std::vector<std::vector<acl::AgentId>> groups;
+    std::vector<acl::ACLMessage> mail;      // this phase's messages, one copy each
 };
 
 #endif
\ No newline at end of file
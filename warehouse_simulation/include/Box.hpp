@@ -1,21 +1,22 @@
 #ifndef BOX_HPP
 #define BOX_HPP
 
-#include <SFML/Graphics.hpp>
-
 class Box {
 public:
     int x, y;              
     int stackSize;       
     bool isPivot;
 
+    static constexpr int MAX_STACK = 5;    // a full stack; a pivot that reaches it closes
+
     Box(int x, int y, int stackSize = 1);
 
     // Merge stacks: add sizes, cap at 5
     void merge(Box& other);
 
-    // Render on SFML window
-    void draw(sf::RenderWindow& window, int cellSize) const;
+    // Stacks taller than this are never targeted: robots carry single boxes,
+    // but before there is a pivot any unfinished stack can become it
+    static int targetLimit(bool pivotExists) { return pivotExists ? 2 : 5; }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef BOXINDEX_HPP
+#define BOXINDEX_HPP
+
+#include <climits>
+#include <functional>
+#include <vector>
+
+#include "BoxStore.hpp"
+
+// What a nearest-box query may return
+struct BoxFilter {
+    int maxStack = INT_MAX;     // skip stacks of this height or taller
+    bool skipPivots = false;
+    std::function<bool(BoxHandle, const Box&)> accept;     // extra check (claims, refusals); may be empty
+};
+
+// Boxes on the floor bucketed into square tiles. Nearest-box queries visit
+// tiles in rings around the query cell and stop as soon as no unvisited tile
+// can hold anything closer, so the cost follows the local box density rather
+// than the grid area. Kept in sync by Grid whenever a box lands or leaves.
+class BoxIndex {
+public:
+    static constexpr int TILE = 8;
+
+    // Positions and stack heights are read through `store`
+    BoxIndex(const BoxStore& store, int rows, int cols);
+
+    void insert(BoxHandle box);
+    void remove(BoxHandle box);     // call while the box still exists
+
+    int size() const { return count; }
+
+    // Fills `out` with up to k boxes passing `filter`, nearest first by
+    // Manhattan distance (ties in row-major order). Returns how many were found.
+    int nearest(int x, int y, int k, const BoxFilter& filter, std::vector<BoxHandle>& out) const;
+
+private:
+    int tileOf(int x, int y) const { return (y / TILE) * tilesX + (x / TILE); }
+
+    const BoxStore& store;
+    int tilesX, tilesY;
+    int count = 0;
+    std::vector<std::vector<BoxHandle>> tiles;
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef BOXSTORE_HPP
+#define BOXSTORE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Box.hpp"
+
+// Names a box in a BoxStore. The generation changes every time a slot is
+// reused, so a handle kept past its box's destruction resolves to nothing
+// instead of to whichever box took the slot over.
+struct BoxHandle {
+    uint32_t slot = 0;
+    uint32_t generation = 0;    // 0 = no box
+
+    explicit operator bool() const { return generation != 0; }
+    bool operator==(const BoxHandle& o) const { return slot == o.slot && generation == o.generation; }
+    bool operator!=(const BoxHandle& o) const { return !(*this == o); }
+
+    // Unique over the life of the store and never 0
+    uint64_t key() const { return (uint64_t(generation) << 32) | slot; }
+    static BoxHandle fromKey(uint64_t key) {
+        return {static_cast<uint32_t>(key), static_cast<uint32_t>(key >> 32)};
+    }
+};
+
+// Slot map owning every box of a simulation, on the floor or carried. Boxes
+// live contiguously in creation order minus removals (the last box fills the
+// hole), so sweeping all of them is a linear pass over a dense array. Once
+// reserve() has covered the box count, creating and destroying boxes never
+// allocates. Box pointers from get() and at() stay valid only until the next
+// create() or destroy(); keep handles across those.
+class BoxStore {
+public:
+    void reserve(size_t count);
+
+    BoxHandle create(int x, int y, int stackSize = 1);
+    void destroy(BoxHandle handle);     // stale or empty handles are ignored
+
+    bool contains(BoxHandle handle) const {
+        return handle && handle.slot < slots.size() && slots[handle.slot].generation == handle.generation;
+    }
+    Box* get(BoxHandle handle) { return contains(handle) ? &items[slots[handle.slot].dense] : nullptr; }
+    const Box* get(BoxHandle handle) const { return contains(handle) ? &items[slots[handle.slot].dense] : nullptr; }
+
+    // Dense view: at(i) for i < size(), in no particular order
+    size_t size() const { return items.size(); }
+    Box& at(size_t i) { return items[i]; }
+    const Box& at(size_t i) const { return items[i]; }
+    BoxHandle handleAt(size_t i) const { return {owners[i], slots[owners[i]].generation}; }
+
+private:
+    struct Slot {
+        uint32_t dense;         // position in items while alive, next free slot otherwise
+        uint32_t generation;
+    };
+
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+    std::vector<Box> items;
+    std::vector<uint32_t> owners;       // owners[i] is the slot of items[i]
+    std::vector<Slot> slots;
+    uint32_t freeHead = NO_SLOT;
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef CELLARRAY_HPP
+#define CELLARRAY_HPP
+
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Allocator for the per-cell layers of a Grid. Memory comes from calloc,
+// which hands large blocks out as fresh zero pages without writing them, and
+// default construction is skipped because all-zero bytes already are the
+// default of every type kept this way (no wall, no box, height 0). Sizing a
+// 10k x 10k grid therefore costs no per-cell work; pages are faulted in as
+// cells are touched.
+//
+// Only valid for arrays sized once: shrinking and then growing again would
+// expose stale elements instead of zeros.
+template <class T>
+struct ZeroedAllocator {
+    static_assert(std::is_trivially_copyable<T>::value, "cell layers hold plain values");
+    using value_type = T;
+
+    ZeroedAllocator() = default;
+    template <class U>
+    ZeroedAllocator(const ZeroedAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        void* p = std::calloc(n, sizeof(T));
+        if (!p) throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+    void deallocate(T* p, size_t) { std::free(p); }
+
+    template <class U>
+    void construct(U*) {}
+    template <class U, class... Args>
+    void construct(U* p, Args&&... args) { ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...); }
+
+    template <class U>
+    bool operator==(const ZeroedAllocator<U>&) const { return true; }
+    template <class U>
+    bool operator!=(const ZeroedAllocator<U>&) const { return false; }
+};
+
+template <class T>
+using CellArray = std::vector<T, ZeroedAllocator<T>>;
+
+#endif
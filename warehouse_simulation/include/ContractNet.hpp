@@ -0,0 +1,84 @@
+#ifndef CONTRACTNET_HPP
+#define CONTRACTNET_HPP
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "ACLMessage.hpp"
+
+class Agent;
+
+namespace acl {
+
+struct Proposal {
+    AgentId from;
+    Content bid;
+};
+
+// One call for proposals as seen by its initiator
+struct Negotiation {
+    ConversationId id = 0;
+    Content task;
+    long long started = 0;              // tick the CFP went out
+    long long deadline = 0;             // tick at which silent participants stop counting
+    int awaiting = 0;                   // participants that have not answered yet
+    int refusals = 0;
+    std::vector<Proposal> proposals;    // in arrival order
+};
+
+// FIPA Contract Net, initiator and participant side, for one agent.
+//
+// The initiator broadcasts a CFP and collects PROPOSE / REFUSE answers. A
+// conversation completes once everybody answered or its deadline tick has
+// come; update() then fires its completion callback, which reads the outcome
+// off the answers. Nothing is awarded: the robots only ask whether anyone
+// objects to them taking a box, so there is no proposer to accept or reject.
+// Deadlines are simulation ticks, so the outcome never depends on how fast
+// the host runs.
+//
+// Open conversations live in a fixed table. Ids are the owner's AgentId in
+// the high half and a counter in the low half; the counter only ever moves
+// forward and is chosen so that id % capacity is a free slot, which makes
+// every lookup a single probe.
+class ContractNet {
+public:
+    using Completion = std::function<void(const Negotiation&)>;
+
+    explicit ContractNet(Agent& owner, size_t capacity = 8);
+
+    // Initiator, at tick `now`. Returns 0 when the table is full.
+    ConversationId callForProposals(const Content& task, long long now, long long deadline, Completion done);
+    void cancel(ConversationId id);
+    bool isOpen(ConversationId id) const { return find(id) != nullptr; }
+
+    // Fires the callbacks of every conversation complete at tick `now`
+    void update(long long now);
+
+    // Participant
+    void propose(const ACLMessage& cfp, const Content& bid);
+    void refuse(const ACLMessage& cfp);
+
+    // Records a PROPOSE or REFUSE for an open conversation; false otherwise
+    bool handleReply(const ACLMessage& msg);
+
+private:
+    struct Slot {
+        bool open = false;
+        Negotiation negotiation;
+        Completion done;
+    };
+
+    Slot* find(ConversationId id);
+    const Slot* find(ConversationId id) const;
+    void reply(const ACLMessage& to, Performative performative, const Content& content);
+
+    Agent& owner;
+    std::vector<Slot> slots;
+    uint32_t counter = 0;
+    int openCount = 0;
+};
+
+} // namespace acl
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef COOPERATIVEPLANNER_HPP
+#define COOPERATIVEPLANNER_HPP
+
+#include <vector>
+
+#include "Grid.hpp"
+#include "PathPlanner.hpp"
+#include "ReservationTable.hpp"
+
+enum class WindowOutcome {
+    REACHED,    // waypoint reached and parked on
+    PARTIAL,    // stopped on the free cell closest to the waypoint
+    BLOCKED     // nothing conflict-free was found; the robot stays put
+};
+
+// Windowed cooperative A* (WHCA*). Each robot plans at most `window` moves
+// ahead through (cell, tick) space, waits included, using only slots nobody
+// else reserved; the spatial planner still chooses the overall route and
+// supplies the waypoint at the end of each window. Robots re-plan well before
+// their window runs out, and every search has a fixed expansion budget, so
+// planning cost per tick stays bounded however crowded the floor gets.
+class CooperativePlanner {
+public:
+    CooperativePlanner(int cellCount, int window);
+
+    int window() const { return windowSize; }
+    ReservationTable& table() { return reservations; }
+    const ReservationTable& table() const { return reservations; }
+
+    // Plans to any cell within `radius` moves of `waypoint` (1 = next to a
+    // box). On return steps[i] is the cell for tick + 1 + i. Does not reserve anything.
+    WindowOutcome plan(const Grid& grid, const Robot* self, Pos start, long long tick, Pos waypoint, int radius,
+                       std::vector<Pos>& steps, SearchStats* stats = nullptr) const;
+
+    // Holds start at `tick`, every step after it and parks on the last cell
+    void commit(const Grid& grid, const Robot* self, Pos start, long long tick, const std::vector<Pos>& steps);
+
+private:
+    int windowSize;
+    ReservationTable reservations;
+};
+
+#endif
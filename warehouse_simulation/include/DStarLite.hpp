@@ -0,0 +1,77 @@
+#ifndef DSTARLITE_HPP
+#define DSTARLITE_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "Grid.hpp"
+#include "PathPlanner.hpp"
+
+// Incremental planner (D* Lite) owned by a single robot. It searches backwards
+// from the goal and keeps its g/rhs values between calls; cells reported
+// through onCellChanged are repaired on the next plan() instead of searching
+// from scratch, so only the part of the tree the change touches is redone.
+// Same path contract as PathPlanner: the goal may hold a box, nothing else may.
+class DStarLite : public GridObserver {
+public:
+    explicit DStarLite(Grid& grid);
+    ~DStarLite() override;
+
+    DStarLite(const DStarLite&) = delete;
+    DStarLite& operator=(const DStarLite&) = delete;
+
+    // Returns false and leaves `path` empty when the goal is unreachable.
+    // A new goal restarts the search; the same goal reuses it.
+    bool plan(Pos start, Pos goal, std::vector<Pos>& path, SearchStats* stats = nullptr);
+
+    // Cells changed since the last plan() (the current path may be stale)
+    bool hasPendingChanges() const { return !changed.empty(); }
+
+    void onCellChanged(int idx) override;
+
+private:
+    struct Key {
+        int k1, k2;
+        bool operator<(const Key& o) const { return k1 != o.k1 ? k1 < o.k1 : k2 < o.k2; }
+    };
+    struct QueueEntry {
+        Key key;
+        int idx;
+    };
+
+    static constexpr int INF = 1 << 29;
+
+    static bool queueAfter(const QueueEntry& a, const QueueEntry& b);
+
+    int g(int idx) const { return stamp[idx] == generation ? gScore[idx] : INF; }
+    int rhs(int idx) const { return stamp[idx] == generation ? rhsScore[idx] : INF; }
+    void setG(int idx, int value);
+    void setRhs(int idx, int value);
+
+    bool passable(int idx) const;
+    int heuristic(int a, int b) const;
+    Key keyOf(int idx) const;
+
+    void reset(int goal);
+    void updateVertex(int idx);
+    void push(int idx);
+    int computeShortestPath();
+
+    Grid& grid;
+    int start = -1;
+    int goal = -1;
+    int km = 0;
+
+    // Entries are only valid when their stamp equals the generation, so a
+    // new goal does not have to clear cellCount() values
+    uint32_t generation = 0;
+    std::vector<uint32_t> stamp;
+    std::vector<int> gScore;
+    std::vector<int> rhsScore;
+
+    // Lazy queue: stale entries are dropped when popped
+    std::vector<QueueEntry> queue;
+    std::vector<int> changed;
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef FLOWFIELD_HPP
+#define FLOWFIELD_HPP
+
+#include <climits>
+#include <memory>
+#include <vector>
+
+#include "Grid.hpp"
+#include "Metrics.hpp"
+
+// Breadth-first distances from every cell to one target cell, shared by
+// everything heading there: a robot reads its next step in O(1) instead of
+// searching, however many robots use the field.
+//
+// Walls and boxes block; the target is the source whether or not it holds a
+// box (the pivot always does). Cell changes reported by the grid are queued
+// and repaired on the next lookup, once for everyone: a freed cell sends a
+// wave of shorter distances outwards, and a newly blocked one clears only the
+// cells that have no other neighbour one step closer and fills them back in
+// from their edge. Lookups run in the act phase and the allocation stage,
+// never concurrently.
+class FlowField : public GridObserver {
+public:
+    FlowField(Grid& grid, int target, Metrics* metrics = nullptr);
+    ~FlowField() override;
+
+    FlowField(const FlowField&) = delete;
+    FlowField& operator=(const FlowField&) = delete;
+
+    int target() const { return goal; }
+
+    // Steps from `idx` to the target, -1 if there is no way. A blocked cell
+    // can be arrived at but not passed, like the allocator's box legs: its
+    // distance is one more than its closest free neighbour's.
+    int distance(int idx);
+
+    // The neighbour one step closer (first in neighborOffsets() order), or -1
+    // at the target and where there is no way
+    int nextStep(int idx);
+
+    void onCellChanged(int idx) override;
+
+private:
+    static constexpr int BLOCKED = -1;
+    static constexpr int FAR = INT_MAX;         // free, but no way to the target
+
+    void build();
+    void repair();
+
+    Grid& grid;
+    int goal;
+    Metrics* metrics;
+    std::vector<int> dist;
+    std::vector<int> changed;                   // reported since the last repair, may repeat
+    bool rebuildDue = false;                    // too many changes queued: start over
+};
+
+// The fields in use, looked up by target: the pivot's, which every carrying
+// robot and the allocation stage share, and any other target many robots
+// converge on. The least recently used field is dropped beyond `capacity`.
+class FlowFieldCache {
+public:
+    FlowFieldCache(Grid& grid, Metrics* metrics, size_t capacity = 2);
+
+    FlowField& toward(int target);
+
+private:
+    Grid& grid;
+    Metrics* metrics;
+    size_t capacity;
+    std::vector<std::unique_ptr<FlowField>> fields;     // most recently used last
+};
+
+#endif
@@ -1,45 +1,138 @@
 #ifndef GRID_HPP
 #define GRID_HPP
 
-#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <utility>
 #include <vector>
-#include "Box.hpp"
+#include "BoxIndex.hpp"
+#include "BoxStore.hpp"
+#include "CellArray.hpp"
 
 class Robot;
 
+using Pos = std::pair<int,int>;
+
 enum CellType {
     EMPTY,
     WALL,
 };
 
-struct Cell {
-    CellType type = EMPTY;
-    Box* box = nullptr;   // Pointer to a box stack
+// Notified after a cell's wall, box or stack height changes
+class GridObserver {
+public:
+    virtual ~GridObserver() = default;
+    virtual void onCellChanged(int idx) = 0;
 };
 
+// Cell storage is flat and row-major with a one-cell border on every side.
+// The border is marked as wall, so code that walks neighbours through
+// neighborOffsets() never needs a bounds check. Each concern lives in its
+// own dense layer: wall and box-present bitmasks, a byte plane of stack
+// heights and the handles of the boxes, plus a tile index for nearest-box
+// queries. The boxes themselves live in a BoxStore, carried ones included.
+// The layers start out as untouched zero pages (see CellArray), so only the
+// cells a run actually uses cost memory traffic.
 class Grid {
 public:
     int rows, cols;
-    std::vector<std::vector<Cell>> cells;
 
     Grid(int rows, int cols);
 
+    // Index space (padded). index() only accepts in-bounds coordinates.
+    int index(int x, int y) const { return (y + 1) * stride + (x + 1); }
+    int xOf(int idx) const { return idx % stride - 1; }
+    int yOf(int idx) const { return idx / stride - 1; }
+    int cellCount() const { return stride * (rows + 2); }
+    int rowStride() const { return stride; }
+    bool inBounds(int x, int y) const { return x >= 0 && x < cols && y >= 0 && y < rows; }
+
+    // Right, left, down, up: the same order the robots have always scanned in
+    const int* neighborOffsets() const { return offsets; }
+
+    bool isWall(int idx) const { return testBit(wallBits, idx); }
+    bool hasBox(int idx) const { return testBit(boxBits, idx); }
+    bool isBlocked(int idx) const { return isWall(idx) || hasBox(idx); }
+    BoxHandle boxAt(int idx) const { return boxes[idx]; }
+    int stackHeight(int idx) const { return heights[idx]; }
+
+    // Coordinate conveniences (in-bounds only)
+    bool isWall(int x, int y) const { return isWall(index(x, y)); }
+    bool hasBox(int x, int y) const { return hasBox(index(x, y)); }
+    BoxHandle boxAt(int x, int y) const { return boxAt(index(x, y)); }
+    CellType typeAt(int x, int y) const { return isWall(x, y) ? WALL : EMPTY; }
+
+    // Raw layers, one bit per padded cell
+    const CellArray<uint64_t>& wallMask() const { return wallBits; }
+    const CellArray<uint64_t>& boxMask() const { return boxBits; }
+
+    // Replaces the whole wall layer with a mask in wallMask() format, border
+    // included (a layout file's wall section). Must happen before any box is
+    // placed or observer attached; false if the size or border is wrong.
+    bool loadWalls(const uint64_t* words, size_t count);
+
+    // Walls inside the grid, border excluded
+    long long wallCount() const;
+
+    // Changes whenever a wall is added or removed, so caches built from the
+    // wall layer can tell they are stale without diffing it. Revisions are
+    // drawn from one process-wide sequence, so two grids only share one when
+    // one is a copy of the other with the same walls.
+    uint64_t wallRevision() const { return wallRev; }
+
+    // Spatial index over the boxes currently on the floor
+    const BoxIndex& boxIndex() const { return boxTiles; }
+
+    // Every live box; null for stale handles. The pointer is only good until
+    // the next box is placed or destroyed.
+    Box* box(BoxHandle handle) { return store.get(handle); }
+    const Box* box(BoxHandle handle) const { return store.get(handle); }
+    const BoxStore& boxStore() const { return store; }
+
     // Box management
+    void reserveBoxes(size_t count) { store.reserve(count); }
     void placeBox(int x, int y, int stackSize = 1);
     void removeBox(int x, int y);
 
-    // Check if a box exists
-    bool hasBox(int x, int y) const;
+    // Lifts the box off the grid without destroying it (a robot picks it up)
+    BoxHandle takeBox(int x, int y);
 
-    // Drawing
-    void draw(sf::RenderWindow& window, int cellSize);
+    // Merges `carried` into the stack at (x, y) and destroys it
+    void stackBox(int x, int y, BoxHandle carried);
 
     void addWallRange(int startX, int startY, int endX, int endY);
 
     void addRobot(Robot* robot);
     const std::vector<Robot*>& getRobots() const;
+
+    // Observers are called synchronously from the mutating call
+    void addObserver(GridObserver* observer);
+    void removeObserver(GridObserver* observer);
 private:
+    static bool testBit(const CellArray<uint64_t>& bits, int idx) {
+        return (bits[idx >> 6] >> (idx & 63)) & 1u;
+    }
+    static void setBit(CellArray<uint64_t>& bits, int idx, bool value) {
+        if (value) bits[idx >> 6] |= uint64_t(1) << (idx & 63);
+        else bits[idx >> 6] &= ~(uint64_t(1) << (idx & 63));
+    }
+
+    void setBox(int idx, BoxHandle box);
+    void setWall(int idx, bool wall);
+    void notify(int idx);
+
+    int stride;
+    int offsets[4];
+    uint64_t wallRev = 0;
+
+    CellArray<uint64_t> wallBits;
+    CellArray<uint64_t> boxBits;
+    CellArray<uint8_t> heights;
+    CellArray<BoxHandle> boxes;
+    BoxStore store;
+    BoxIndex boxTiles;      // reads `store`, so declared after it
+
     std::vector<Robot*> robots;
+    std::vector<GridObserver*> observers;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,62 @@
+#ifndef GRIDRENDERER_HPP
+#define GRIDRENDERER_HPP
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include "Grid.hpp"
+#include "Snapshot.hpp"
+
+// Draws simulation snapshots in three draw calls, whatever the grid size:
+// the floor, the boxes and the robots are each one persistent triangle
+// array, all textured from a small atlas built in code (a white texel for
+// solid quads, stack-count digits and the carried-box marker), so no font
+// file is needed.
+//
+// The floor holds one quad per cell and is built once from the grid's walls.
+// The box layer holds one slot per box on the floor and is only rewritten for
+// the boxes that differ from the last snapshot drawn. Robots move every tick
+// and are few, so their array is refilled each frame.
+//
+// Never touches the grid after construction, so it can run on another
+// thread than the simulation. Draws into any sf::RenderTarget, so the same
+// code renders into an sf::RenderTexture when there is no window.
+class GridRenderer {
+public:
+    // Reads the walls; call before the simulation thread starts
+    GridRenderer(const Grid& grid, int cellSize);
+
+    // `alpha` in [0, 1] places robots between their previous and current cell
+    void draw(sf::RenderTarget& target, const Snapshot& snapshot, float alpha);
+
+private:
+    void buildAtlas();
+    void buildFloor(const Grid& grid);
+    void syncBoxes(const Snapshot& snapshot);
+    void writeBox(size_t slot, const SnapshotBox& box);
+    void removeBox(int cell);
+    void fillRobots(const Snapshot& snapshot, float alpha);
+
+    // Writes one quad (two triangles) at vertex `at`
+    static void setQuad(sf::Vertex* at, float x, float y, float w, float h, sf::Color color, sf::FloatRect tex);
+
+    int stride;             // of the padded cell index in snapshots
+    int cellSize;
+    int glyphScale;         // texels of a digit are glyphScale pixels wide; 0 -> no digits
+
+    sf::Texture atlas;
+    sf::VertexArray floor;
+    sf::VertexArray boxes;
+    sf::VertexArray robots;
+
+    // Box slots are kept dense: a removed slot is refilled from the last one
+    std::unordered_map<int, size_t> slotOfCell;
+    std::vector<int> cellOfSlot;
+
+    std::vector<SnapshotBox> drawnBoxes;    // as in the last snapshot drawn
+    uint64_t drawnVersion = 0;
+};
+
+#endif
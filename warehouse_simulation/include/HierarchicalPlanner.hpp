@@ -0,0 +1,113 @@
+#ifndef HIERARCHICALPLANNER_HPP
+#define HIERARCHICALPLANNER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Grid.hpp"
+#include "PathPlanner.hpp"
+
+// Hierarchical path-finding (HPA*) for maps too large to search cell by cell.
+// The grid is cut into square clusters. Wherever two neighbouring clusters
+// share an open stretch of border, one transition across it (two for long
+// stretches) becomes a pair of nodes in an abstract graph. The walls-only
+// distances between the nodes of a cluster are computed the first time a
+// search reaches it, so a large map is ready after one pass over its borders
+// and only the clusters queries actually cross ever cost more.
+//
+// A query between two clusters searches that graph, which is about a
+// hundredth of the size of the grid for the default cluster size, and then
+// refines it hop by hop with an A* confined to the clusters of the hop. Boxes
+// are only seen there: a hop they block is merged with the following ones, and
+// if that fails as well the whole query falls back to A* on the full grid.
+// Queries inside one cluster go to A* directly. Paths follow the PathPlanner
+// contract but are not always the shortest.
+//
+// The graph is built by the first query and repaired by the first query after
+// Grid::wallRevision() moves, rebuilding only the clusters whose walls or
+// shared borders changed. Queries may run concurrently, as in the plan phase,
+// as long as no wall changes meanwhile. Another grid of the same size is
+// repaired the same way; one of another size is built from scratch.
+class HierarchicalPlanner : public PathPlanner {
+public:
+    // Clusters are clusterSize cells square, clamped to [4, 62]
+    explicit HierarchicalPlanner(int clusterSize = 32);
+
+    bool findPath(const Grid& grid, Pos start, Pos goal,
+                  std::vector<Pos>& path, SearchStats* stats = nullptr) const override;
+
+    PlannerKind kind() const override { return PlannerKind::HPA; }
+
+    // Nodes of the abstract graph for `grid`, building it if needed
+    size_t nodeCount(const Grid& grid) const;
+
+private:
+    enum Side { NORTH, SOUTH, WEST, EAST };
+
+    static constexpr uint16_t UNREACHABLE = 0xFFFF;
+
+    struct Rect {
+        int x0, y0, x1, y1;     // x1 and y1 exclusive
+    };
+
+    struct Cluster {
+        uint16_t first[5] = {};         // first node of each side; first[4] is the node count
+        std::vector<int> cells;         // per node
+
+        // Filled in by ensureDistances()
+        bool open = false;              // no walls inside: distances are Manhattan
+        uint64_t stamp = 0;             // new every time
+        std::vector<uint16_t> dist;     // node x node, walls only
+    };
+
+    // Node ids encode (cluster, side, k), so rebuilding one cluster never
+    // renumbers the nodes of another and partners are found arithmetically
+    int nodeId(int cluster, int side, int k) const { return (cluster * 4 + side) * sideSlots + k; }
+    int nodeId(int cluster, int node) const;
+    int idCount() const { return static_cast<int>(clusters.size()) * 4 * sideSlots; }
+
+    int clusterOf(const Grid& grid, int idx) const;
+    Rect bounds(int cluster) const;
+    int neighbour(int cluster, int side) const;
+
+    void ensureBuilt(const Grid& grid) const;
+    void rebuildChanged(const Grid& grid) const;
+    void buildCluster(const Grid& grid, int cluster) const;
+    void ensureDistances(const Grid& grid, int cluster) const;
+    void findTransitions(const Grid& grid, int cluster, int side, std::vector<int>& cells) const;
+
+    // Walls-only distances from `idx` to the nodes of its cluster, from
+    // node `needFrom` on (the others are left UNREACHABLE)
+    void distancesFrom(const Grid& grid, int cluster, int idx, std::vector<uint16_t>& out,
+                       size_t needFrom = 0) const;
+
+    // Cells the abstract route passes through, start and goal included
+    bool searchAbstract(const Grid& grid, int start, int goal, std::vector<int>& waypoints, int& expanded) const;
+
+    // A* from `from` to `to` inside `area`, boxes blocking except at `to`;
+    // appends the cells after `from`
+    bool searchWithin(const Grid& grid, int from, int to, Rect area, std::vector<Pos>& path, int& expanded) const;
+
+    int clusterSize;
+    int sideSlots;          // most transitions one side can have
+    std::unique_ptr<PathPlanner> direct;
+
+    // The abstraction. Readers check builtRevision (0 = nothing built); only
+    // the thread holding buildMutex changes anything.
+    mutable std::mutex buildMutex;
+    mutable std::atomic<uint64_t> builtRevision{0};
+    mutable int clustersX = 0, clustersY = 0;
+    mutable int rows = 0, cols = 0;
+    mutable std::vector<Cluster> clusters;
+    mutable std::vector<uint64_t> builtWalls;   // the wall layer the clusters reflect
+
+    // Per cluster: distances computed. Set under distanceMutex during queries,
+    // cleared under buildMutex when the walls change.
+    mutable std::unique_ptr<std::atomic<bool>[]> ready;
+    mutable std::mutex distanceMutex;
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef LAYOUT_HPP
+#define LAYOUT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct LayoutBox {
+    int32_t x, y;
+    int32_t height;     // 1-5 boxes in the stack
+};
+
+struct LayoutDock {
+    int32_t x, y;       // a robot starts here
+};
+
+// A warehouse floor plan: walls and shelves, initial box stacks and robot
+// docks, in one of two forms.
+//
+// Text, for authoring. One directive per line; '#' starts a comment:
+//
+//   warehouse-layout 1
+//   size COLS ROWS
+//   wall X0 Y0 X1 Y1       inclusive rectangle
+//   shelf X0 Y0 X1 Y1      storage racks; impassable, stored as wall
+//   box X Y [HEIGHT]       a stack of 1-5 boxes (default 1)
+//   dock X Y               a robot start cell
+//   map                    followed by ROWS lines of COLS cells:
+//                          . floor, # wall, S shelf, 1-5 box stack, D dock
+//
+// Binary, for speed. A fixed 48-byte header, then the wall layer in Grid's
+// own padded bitmask format (see Grid::wallMask), then the boxes and the
+// docks as packed little-endian int32 records. The file is memory-mapped
+// and the wall words are copied into the grid as they are: loading does no
+// per-cell work at all, only a pass over the boxes and docks.
+class Layout {
+public:
+    int rows = 0, cols = 0;
+
+    const uint64_t* wallWords() const { return walls; }
+    size_t wallWordCount() const { return wallCount; }
+    const LayoutBox* boxes() const { return boxList; }
+    size_t boxCount() const { return boxTotal; }
+    const LayoutDock* docks() const { return dockList; }
+    size_t dockCount() const { return dockTotal; }
+
+    bool isWall(int x, int y) const;
+
+    // Words in the wall layer of a rows x cols grid, border included
+    static size_t maskWords(int rows, int cols);
+
+private:
+    friend std::shared_ptr<const Layout> loadLayout(const std::string& path, std::string& error);
+
+    bool parseText(std::istream& in, const std::string& name, std::string& error);
+    bool mapBinary(const std::string& path, std::string& error);
+
+    // Text layouts own their data; binary ones point into the mapping
+    std::vector<uint64_t> ownedWalls;
+    std::vector<LayoutBox> ownedBoxes;
+    std::vector<LayoutDock> ownedDocks;
+    std::shared_ptr<const void> mapping;
+
+    const uint64_t* walls = nullptr;
+    size_t wallCount = 0;
+    const LayoutBox* boxList = nullptr;
+    size_t boxTotal = 0;
+    const LayoutDock* dockList = nullptr;
+    size_t dockTotal = 0;
+};
+
+// Reads either form; they are told apart by the first bytes
+std::shared_ptr<const Layout> loadLayout(const std::string& path, std::string& error);
+
+bool saveLayoutBinary(const Layout& layout, const std::string& path, std::string& error);
+bool saveLayoutText(const Layout& layout, const std::string& path, std::string& error);
+
+#endif
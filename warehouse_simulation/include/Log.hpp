@@ -0,0 +1,158 @@
+#ifndef LOG_HPP
+#define LOG_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <type_traits>
+
+// Compile-time floor. Log statements below it are removed by the
+// preprocessor, arguments and all. Build with
+// -DWAREHOUSE_LOG_LEVEL=WAREHOUSE_LOG_<LEVEL> (the makefile's LOG_LEVEL);
+// by default release (NDEBUG) builds keep warnings and errors only.
+#define WAREHOUSE_LOG_TRACE 0
+#define WAREHOUSE_LOG_DEBUG 1
+#define WAREHOUSE_LOG_INFO  2
+#define WAREHOUSE_LOG_WARN  3
+#define WAREHOUSE_LOG_ERROR 4
+#define WAREHOUSE_LOG_OFF   5
+
+#ifndef WAREHOUSE_LOG_LEVEL
+#ifdef NDEBUG
+#define WAREHOUSE_LOG_LEVEL WAREHOUSE_LOG_WARN
+#else
+#define WAREHOUSE_LOG_LEVEL WAREHOUSE_LOG_TRACE
+#endif
+#endif
+
+// Asynchronous logging. A log statement that passes the level check packs
+// its format string and arguments into a fixed-size binary record and pushes
+// it onto a lock-free ring buffer; a background thread formats the records
+// and writes them out. The caller never formats, allocates or waits for I/O,
+// and when the buffer is full the record is dropped (and counted) rather
+// than blocking the tick.
+namespace logging {
+
+enum class Level : uint8_t { TRACE, DEBUG, INFO, WARN, ERROR, OFF };
+
+enum class Category : uint8_t {
+    SIM,        // run setup and progress
+    ROBOT,      // robot decisions
+    PLANNER,    // path searches
+    ACL,        // messaging and negotiation
+    COUNT
+};
+
+// One argument: a number, or a string with static storage (a literal)
+struct Arg {
+    enum Kind : uint8_t { INT, UINT, REAL, TEXT } kind;
+    union {
+        long long i;
+        unsigned long long u;
+        double d;
+        const char* s;
+    };
+};
+
+template <class T>
+Arg makeArg(T value) {
+    Arg a;
+    if constexpr (std::is_enum<T>::value) {
+        a.kind = Arg::INT;
+        a.i = static_cast<long long>(value);
+    } else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value) {
+        a.kind = Arg::INT;
+        a.i = value;
+    } else if constexpr (std::is_integral<T>::value) {
+        a.kind = Arg::UINT;
+        a.u = value;
+    } else if constexpr (std::is_floating_point<T>::value) {
+        a.kind = Arg::REAL;
+        a.d = value;
+    } else {
+        static_assert(std::is_convertible<T, const char*>::value,
+                      "log arguments are numbers or string literals");
+        a.kind = Arg::TEXT;
+        a.s = value;
+    }
+    return a;
+}
+
+constexpr int MAX_ARGS = 6;
+
+struct Record {
+    const char* format;     // literal; each {} takes the next argument
+    Level level;
+    Category category;
+    uint8_t argc;
+    Arg args[MAX_ARGS];
+};
+
+// Runtime threshold per category; everything is OFF until start()
+extern std::atomic<uint8_t> thresholds[static_cast<int>(Category::COUNT)];
+
+inline bool enabled(Level level, Category category) {
+    return static_cast<uint8_t>(level) >=
+           thresholds[static_cast<int>(category)].load(std::memory_order_relaxed);
+}
+
+void submit(const Record& record);
+
+template <class... Args>
+void write(Level level, Category category, const char* format, Args... args) {
+    static_assert(sizeof...(Args) <= MAX_ARGS, "too many log arguments");
+    Record record{format, level, category, static_cast<uint8_t>(sizeof...(Args)), {makeArg(args)...}};
+    submit(record);
+}
+
+// Starts the formatter thread writing to `out` with every category at
+// `level`. stop() disables logging, drains the buffer and joins the thread;
+// call it before writing anything else to `out`.
+void start(std::ostream& out, Level level);
+void stop();
+
+void setLevel(Category category, Level level);
+
+// Records lost to a full buffer since start()
+uint64_t droppedCount();
+
+} // namespace logging
+
+#define WLOG(level, category, ...)                                                         \
+    do {                                                                                   \
+        if (::logging::enabled(::logging::Level::level, ::logging::Category::category))    \
+            ::logging::write(::logging::Level::level, ::logging::Category::category,       \
+                             __VA_ARGS__);                                                 \
+    } while (0)
+
+#if WAREHOUSE_LOG_LEVEL <= WAREHOUSE_LOG_TRACE
+#define WLOG_TRACE(category, ...) WLOG(TRACE, category, __VA_ARGS__)
+#else
+#define WLOG_TRACE(category, ...) ((void)0)
+#endif
+
+#if WAREHOUSE_LOG_LEVEL <= WAREHOUSE_LOG_DEBUG
+#define WLOG_DEBUG(category, ...) WLOG(DEBUG, category, __VA_ARGS__)
+#else
+#define WLOG_DEBUG(category, ...) ((void)0)
+#endif
+
+#if WAREHOUSE_LOG_LEVEL <= WAREHOUSE_LOG_INFO
+#define WLOG_INFO(category, ...) WLOG(INFO, category, __VA_ARGS__)
+#else
+#define WLOG_INFO(category, ...) ((void)0)
+#endif
+
+#if WAREHOUSE_LOG_LEVEL <= WAREHOUSE_LOG_WARN
+#define WLOG_WARN(category, ...) WLOG(WARN, category, __VA_ARGS__)
+#else
+#define WLOG_WARN(category, ...) ((void)0)
+#endif
+
+#if WAREHOUSE_LOG_LEVEL <= WAREHOUSE_LOG_ERROR
+#define WLOG_ERROR(category, ...) WLOG(ERROR, category, __VA_ARGS__)
+#else
+#define WLOG_ERROR(category, ...) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <vector>
+
+#include "ACLMessage.hpp"
+
+// Named counters of one run
+enum class Counter : uint8_t {
+    PATH_SEARCHES,      // full routes (shared planner or D* Lite)
+    WINDOW_SEARCHES,    // cooperative reservation windows
+    NODES_EXPANDED,     // over both kinds of search
+    PICKS,              // boxes lifted off the floor
+    STACKS,             // boxes merged onto the pivot
+    PIVOTS,             // boxes promoted to pivot
+    FIELD_BUILDS,       // flow fields computed from scratch
+    FIELD_REPAIRS,      // flow field updates after cell changes
+    COUNT
+};
+
+// Value distributions, bucketed by powers of two
+enum class Histogram : uint8_t {
+    NODES_PER_SEARCH,
+    CONVERSATION_TICKS,     // call for proposals until its outcome
+    TICK_MICROS,            // wall time of one step()
+    COUNT
+};
+
+// Why a robot neither moved nor lifted/stacked anything on a tick
+enum class IdleCause : uint8_t {
+    NO_BOX,         // nothing left to fetch
+    PIVOT_FULL,     // beside its box, but the pivot has no room for it yet
+    RESERVATION,    // cooperative mode: holding a reserved cell
+    NO_ROUTE,       // the planner found no path to the target
+    OTHER,          // negotiating, arriving, waiting on a stacked box...
+    COUNT
+};
+
+constexpr size_t PERFORMATIVE_COUNT = static_cast<size_t>(acl::Performative::REJECT_PROPOSAL) + 1;
+
+// Per-subsystem counters and histograms of one simulation (owned by its
+// SimulationContext).
+//
+// Updates go to one of a few cache-line-aligned shards, picked per thread,
+// as relaxed atomic adds; plan-phase workers therefore never contend on a
+// lock or (as long as there are fewer threads than shards) on a cache line.
+// Readers sum the shards. The per-robot idle table is written only from the
+// act phase, which runs on the stepping thread.
+class Metrics {
+public:
+    static constexpr size_t SHARDS = 16;
+    static constexpr size_t BUCKETS = 40;   // bucket b holds values in [2^(b-1), 2^b)
+
+    Metrics();
+
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    // Threads are numbered on first use and keep their shard for life
+    static size_t threadShard();
+
+    void add(Counter counter, long long amount = 1);
+    void record(Histogram histogram, long long value);
+
+    // One envelope leaving the registry, and how many agents it reached
+    void countMessage(acl::Performative performative, size_t receivers);
+
+    // Act phase only
+    void idle(acl::AgentId robot, IdleCause cause);
+
+    long long total(Counter counter) const;
+    long long messages(acl::Performative performative) const;
+
+    struct Summary {
+        long long count = 0;
+        long long sum = 0;
+        long long max = 0;
+        std::array<long long, BUCKETS> buckets{};
+        long long percentile(double p) const;   // upper bound of the bucket holding it
+    };
+    Summary summary(Histogram histogram) const;
+
+    // One JSON object on a single line, tagged with the tick it was taken at
+    void writeJson(std::ostream& out, long long tick) const;
+
+private:
+    struct Hist {
+        std::atomic<long long> count{0};
+        std::atomic<long long> sum{0};
+        std::atomic<long long> max{0};
+        std::atomic<long long> buckets[BUCKETS] = {};
+    };
+
+    struct alignas(64) Shard {
+        std::atomic<long long> counters[static_cast<size_t>(Counter::COUNT)] = {};
+        std::atomic<long long> sent[PERFORMATIVE_COUNT] = {};
+        std::atomic<long long> delivered[PERFORMATIVE_COUNT] = {};
+        Hist histograms[static_cast<size_t>(Histogram::COUNT)];
+    };
+
+    Shard& local();
+
+    std::unique_ptr<Shard[]> shards;
+    std::vector<std::array<long long, static_cast<size_t>(IdleCause::COUNT)>> robotIdle;   // by AgentId
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef PATHPLANNER_HPP
+#define PATHPLANNER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Grid.hpp"
+
+enum class PlannerKind {
+    DIJKSTRA,
+    ASTAR,
+    JPS,
+    HPA
+};
+
+bool parsePlannerKind(const std::string& text, PlannerKind& kind);
+const char* plannerKindName(PlannerKind kind);
+
+struct SearchStats {
+    int expanded = 0;       // nodes popped from the open list
+};
+
+// Scratch arrays for one search at a time. Entries are only valid when their
+// stamp equals the current generation, so starting a new search is O(1)
+// instead of clearing cellCount() entries. One workspace per thread.
+class SearchWorkspace {
+public:
+    struct OpenEntry {
+        int f;
+        int g;
+        int idx;
+    };
+
+    static SearchWorkspace& local();
+
+    // Grows the arrays if needed and invalidates every entry
+    void begin(int cellCount);
+
+    bool seen(int idx) const { return stamp[idx] == generation; }
+    bool closed(int idx) const { return closedStamp[idx] == generation; }
+    int g(int idx) const { return gScore[idx]; }
+    int parentOf(int idx) const { return parent[idx]; }
+
+    void open(int idx, int g, int f, int from) {
+        stamp[idx] = generation;
+        gScore[idx] = g;
+        parent[idx] = from;
+        push({f, g, idx});
+    }
+    void close(int idx) { closedStamp[idx] = generation; }
+
+    bool empty() const { return heap.empty(); }
+    OpenEntry pop();
+
+private:
+    void push(const OpenEntry& e);
+
+    uint32_t generation = 0;
+    std::vector<uint32_t> stamp;
+    std::vector<uint32_t> closedStamp;
+    std::vector<int> gScore;
+    std::vector<int> parent;
+    std::vector<OpenEntry> heap;
+};
+
+// A shortest-path backend for 4-connected grids. Paths run from the cell after
+// `start` up to and including `goal`, which may hold a box (robots stop next
+// to it); every other box and wall blocks. Planners keep no per-query state,
+// so one instance can serve every robot of a simulation.
+class PathPlanner {
+public:
+    virtual ~PathPlanner() = default;
+
+    // Returns false and leaves `path` empty when the goal is unreachable
+    virtual bool findPath(const Grid& grid, Pos start, Pos goal,
+                          std::vector<Pos>& path, SearchStats* stats = nullptr) const = 0;
+
+    virtual PlannerKind kind() const = 0;
+};
+
+std::unique_ptr<PathPlanner> makePlanner(PlannerKind kind);
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef PIVOTMANAGER_HPP
+#define PIVOTMANAGER_HPP
+
+#include <vector>
+
+#include "BoxStore.hpp"
+#include "Grid.hpp"
+
+class Robot;
+class SimulationContext;
+
+// Decides where boxes are stacked. The open pivots themselves and their
+// reservations live on the blackboard (SharedMemory); this is the policy.
+//
+// With one pivot slot (the default) a pivot is opened by the first robot to
+// reach its box while there is none, and every box goes to it. With more
+// slots, the allocation stage opens pivots whenever the loose boxes outnumber
+// the room left on the open ones: the loose boxes are clustered around the
+// open pivots plus one new centre per pivot wanted (k-means on Manhattan
+// distance, seeded farthest first), and each new centre opens on the box
+// nearest to it. A robot that lifts a box reserves room on the closest open
+// pivot that has some, so several stacks fill at once.
+class PivotManager {
+public:
+    explicit PivotManager(SimulationContext& context) : context(context) {}
+
+    PivotManager(const PivotManager&) = delete;
+    PivotManager& operator=(const PivotManager&) = delete;
+
+    // Allocation stage: opens pivots in free slots where the remaining boxes
+    // call for them. Does nothing with a single slot.
+    void openPivots(Grid& grid);
+
+    // Marks `box` as the pivot in `slot`
+    void open(Grid& grid, BoxHandle box, int slot);
+
+    // Whether the robot standing beside `box` may make it a pivot itself. In
+    // cooperative mode a box with a single free side is refused while a
+    // roomier loose box is left for openPivots() to choose instead.
+    bool mayOpen(const Grid& grid, BoxHandle box, const Robot* standing) const;
+
+    // Slot of the open pivot with room for one more box that is fewest steps
+    // from `cell`, or -1 if every one is full or spoken for. Act phase only.
+    int bestPivotFor(const Grid& grid, int cell);
+
+private:
+    static constexpr int KMEANS_ROUNDS = 8;
+
+    // Sides a robot can stand on to stack: free and, in cooperative mode,
+    // not taken by a robot parked there other than `standing`
+    int freeSides(const Grid& grid, int idx, const Robot* standing) const;
+    static constexpr int ROOMY_SIDES = 2;
+
+    SimulationContext& context;
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef RESERVATIONTABLE_HPP
+#define RESERVATIONTABLE_HPP
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class Robot;
+
+// Space-time occupancy shared by the robots of one simulation. A robot holds
+// (cell, tick) slots along its planned window and then parks on its last cell,
+// which it keeps from that tick on until it plans again. Every robot therefore
+// covers every future tick, and a cooperative plan that only uses free slots
+// cannot collide with anyone.
+class ReservationTable {
+public:
+    explicit ReservationTable(int cellCount);
+
+    // Robot holding idx at tick, or nullptr
+    const Robot* holder(int idx, long long tick) const;
+    bool isFree(int idx, long long tick, const Robot* self) const {
+        const Robot* h = holder(idx, tick);
+        return h == nullptr || h == self;
+    }
+
+    // Moving from -> to between tick and tick + 1 would swap places with someone
+    bool swapConflict(int from, int to, long long tick, const Robot* self) const;
+
+    // No other robot holds idx at any tick from `from` on
+    bool canPark(int idx, long long from, const Robot* self) const;
+
+    void reserve(int idx, long long tick, const Robot* self);
+    void park(int idx, long long from, const Robot* self);
+
+    // Drops every slot and the parking spot held by `self`
+    void release(const Robot* self);
+
+    // Robot parked on idx by `tick`, or nullptr
+    const Robot* parkedOn(int idx, long long tick) const {
+        const Parking& p = parking[idx];
+        return p.robot && tick >= p.from ? p.robot : nullptr;
+    }
+
+    // A robot whose window falls short asks the robots parked on its way to
+    // move off `cells`; each one picks its request up the next time it acts.
+    // Of the requests made in the meantime only the first with the highest
+    // priority is kept: honouring several at once could leave it nowhere to go.
+    struct YieldRequest {
+        int priority = 0;
+        std::vector<int> cells;
+        std::vector<const Robot*> chain;    // who passed it on, last the asker; never crossed
+    };
+    void askToYield(const Robot* parked, const YieldRequest& ask);
+    bool takeYieldRequest(const Robot* self, YieldRequest& request);
+
+    // A robot that had nowhere to go when asked is not asked again for a
+    // while, so the robots behind it look for a way round instead
+    void markBoxedIn(const Robot* self, long long tick) { boxedInAt[self] = tick; }
+    bool boxedIn(const Robot* robot, long long tick) const {
+        auto it = boxedInAt.find(robot);
+        return it != boxedInAt.end() && tick - it->second < BOXED_IN_TICKS;
+    }
+
+private:
+    struct Parking {
+        const Robot* robot = nullptr;
+        long long from = 0;
+    };
+
+    uint64_t key(int idx, long long tick) const {
+        return static_cast<uint64_t>(tick) * static_cast<uint64_t>(cells) + static_cast<uint64_t>(idx);
+    }
+
+    int cells;
+    long long horizon = 0;      // latest tick any slot was reserved for
+    std::unordered_map<uint64_t, const Robot*> slots;
+    std::unordered_map<const Robot*, std::vector<uint64_t>> held;
+    std::unordered_map<const Robot*, int> parkedAt;
+    std::vector<Parking> parking;
+    std::unordered_map<const Robot*, YieldRequest> yieldRequests;
+    static constexpr long long BOXED_IN_TICKS = 8;
+    std::unordered_map<const Robot*, long long> boxedInAt;
+};
+
+#endif
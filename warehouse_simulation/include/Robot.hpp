@@ -1,8 +1,13 @@
 #pragma once
-#include <SFML/Graphics.hpp>
 #include "Grid.hpp"
 #include "Agent.hpp"
+#include "DStarLite.hpp"
+#include "Metrics.hpp"
+#include "ReservationTable.hpp"
 #include <functional>
+#include <memory>
+
+class SimulationContext;
 
 enum RobotState {
     EXPLORING,
@@ -11,42 +16,127 @@ enum RobotState {
     STACKING
 };
 
-enum class ACLPerformative {
-    QUERY_REF,
-    INFORM
-};
-
-struct ACLMessage {
-    ACLPerformative performative;
-    Box* box;
-    bool free;
-    Robot* sender;
-};
-
 class Robot: public Agent {
 public:
     int x, y;
     bool carrying;
-    Box* carriedBox;
+    BoxHandle carriedBox;
 
     RobotState state;
-    Robot(const std::string& name, int startX, int startY);
+    Robot(const std::string& name, int startX, int startY, SimulationContext& context);
 
-    Box* targetBox = nullptr;
+    BoxHandle targetBox;
 
     void update(Grid& grid);
-    bool go_to(const Grid& grid, const sf::Vector2f& target, std::function<bool(Robot*)> onReached);
+    bool go_to(const Grid& grid, const Pos& target, std::function<bool(Robot*)> onReached);
     bool tryPickup(Grid& grid);
 
+    // Plan phase: route search and box query against the grid as it stands at
+    // the start of the tick. Runs concurrently for every robot, so it only
+    // reads shared state and writes this robot's own scratch fields; update()
+    // picks the results up in the act phase.
+    void prepare(const Grid& grid);
+
+    // Central allocation stage (any --assign mode but negotiate)
+    bool needsTask() const { return state == MOVING_TO_BOX && !targetBox && !carrying && !candidateBox; }
+    void assignTask(BoxHandle box);
+
+    // Heading for `box` or negotiating for it
+    bool wants(BoxHandle box) const { return targetBox == box || candidateBox == box; }
+
     virtual void receive(const acl::ACLMessage& msg) override;
     virtual void handleResponse(const acl::ACLMessage& msg) override;
 
 private:
-    bool inBounds(const Grid& grid, int nx, int ny);
+    SimulationContext& context;
+
     bool tryStack(Grid& grid);
-    bool isBoxTargetedByOthers(Box* box, const std::vector<Robot*>& allRobots);
-    Box* findNearestNonPivotBox(Grid& grid, const std::vector<Robot*>& allRobots);
-    bool checkBoxAvailability(Box* box, const std::vector<Robot*>& robots);
+
+    // Every state change goes through here, so the blackboard's count of
+    // boxes heading to each pivot stays exact
+    void setState(RobotState next);
+
+    // The pivot the carried box has a place on, while it is still open
+    BoxHandle targetPivot;
+    const Box* reservedPivot(const Grid& grid) const;
+    bool promoteTarget(Grid& grid, int slot);       // the target box becomes the pivot in `slot`
+    bool isBoxTargetedByOthers(BoxHandle box, const std::vector<Robot*>& allRobots);
+    BoxHandle findNearestNonPivotBox(Grid& grid, const std::vector<Robot*>& allRobots);
+
+    // Non-blocking box negotiation: a Contract Net call goes out on one tick
+    // and the answers are collected on a later one, while the robot keeps moving.
+    // Peers propose when they have no objection and refuse when they hold or
+    // want the box; any refusal loses the claim.
+    static constexpr long long QUERY_TIMEOUT_TICKS = 4;
+    void startAvailabilityQuery(const Grid& grid, BoxHandle box);
+    void onAvailabilityAnswered(const acl::Negotiation& negotiation);
+
+    BoxHandle candidateBox;             // box under negotiation
+    Pos candidatePos = {-1, -1};
+    acl::ConversationId queryConvId = 0;
+    std::vector<BoxHandle> rejectedBoxes;    // refused this round, skipped until a box is won
+
+    // Only with --replan incremental; otherwise the shared planner is used
+    std::unique_ptr<DStarLite> incremental;
+    void planRoute(const Grid& grid, const Pos& target);
+    void computeRoute(const Grid& grid, const Pos& target, std::vector<Pos>& path);
+
+    // Where update() will head this tick, and whether it will need a new route
+    bool upcomingGoal(const Grid& grid, Pos& target);
+    bool routeDue(const Pos& target) const;
+    bool windowRunningDry() const;
+    bool preparedRouteFor(const Pos& target) const {
+        return hasPreparedRoute && preparedTarget == target && preparedFrom == Pos(x, y);
+    }
+
+    // Plan-phase results, consumed by the act phase of the same tick
+    static constexpr int SENSED_BOXES = 8;
+    std::vector<Pos> preparedPath;
+    Pos preparedFrom = {-1, -1};
+    Pos preparedTarget = {-1, -1};
+    bool hasPreparedRoute = false;
+    std::vector<BoxHandle> sensedBoxes;     // nearest boxes by static filters only
+    Pos sensedFrom = {-1, -1};
+    bool hasSensedBoxes = false;
+
+    // --flow-field: the trip to the pivot reads the pivot's shared field
+    // instead of searching a route of its own
+    bool followsField() const;
+    bool followField(const Grid& grid, const Pos& target, std::function<bool(Robot*)> onReached);
+
+    // Cooperative mode: follow reserved (cell, tick) slots instead of the raw route
+    bool goCooperative(const Grid& grid, const Pos& target, std::function<bool(Robot*)> onReached);
+    void replanWindow(const Grid& grid, const Pos& target);
+    bool holdPosition(const Grid& grid);
+    void stepAside(const Grid& grid);     // idle robots leave the cells beside boxes free
+    bool moveToNearest(const Grid& grid, const std::function<bool(int)>& fits,
+                       const ReservationTable::YieldRequest* request);
+    // Who makes way for whom: carrying robots keep the stacks growing, so they
+    // outrank robots fetching a box, which outrank idle ones and those with no
+    // route to their box. A robot moving off passes the rank of whoever asked
+    // it on to the robots in its own way.
+    int yieldRank() const;
+    bool stranded = false;                // the last route search found no way to the target
+    void askParkedToYield(const Grid& grid, const Pos& waypoint, int radius);
+    void askAlong(const std::vector<int>& way, ReservationTable::YieldRequest ask);
+    bool makeWay(const Grid& grid);       // honours a yield request; true if it moves off
+    static constexpr int PUSH_COST = 4;   // extra moves charged for a way through a parked robot
+    void followWindow();
+
+    void decide(Grid& grid);
+    void countSearch(Counter kind, const SearchStats& stats);
+
+    // Act-phase bookkeeping: a tick without a move or a lift/stack counts as
+    // idle, charged to the last cause decide() ran into
+    IdleCause idleCause = IdleCause::OTHER;
+    bool worked = false;
+
+    std::vector<Pos> windowSteps;       // windowSteps[i] is the cell for tick windowTick + 1 + i
+    Pos windowStart = {-1, -1};         // cell held at windowTick
+    long long windowTick = 0;
+    long long lastStepTick = -1;
+    bool windowFinal = false;           // the window ends beside the target
+
     std::vector<std::pair<int,int>> currentPath;
     std::pair<int,int> currentTarget = {-1, -1};
 };
\ No newline at end of file
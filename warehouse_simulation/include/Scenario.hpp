@@ -0,0 +1,64 @@
+#ifndef SCENARIO_HPP
+#define SCENARIO_HPP
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Layout.hpp"
+#include "PathPlanner.hpp"
+#include "TaskAllocator.hpp"
+
+struct WallRange {
+    int startX, startY, endX, endY;
+};
+
+enum class ReplanMode {
+    ON_TARGET,      // plan once per target with the shared planner
+    INCREMENTAL     // per-robot D* Lite, repaired as boxes come and go
+};
+
+// Everything needed to lay out a run: grid size, walls, spawn counts and seed.
+struct ScenarioConfig {
+    int rows = 30;
+    int cols = 30;
+    int robotCount = 5;
+    int boxCount = 17;
+    std::vector<WallRange> walls = {{10, 10, 15, 15}};
+
+    std::string layoutPath;     // --layout: replaces size and walls, and boxes if it has any
+    std::shared_ptr<const Layout> layout;
+
+    unsigned int seed = 0;
+    bool seedGiven = false;     // false -> seed is drawn from std::random_device
+
+    PlannerKind planner = PlannerKind::ASTAR;
+    ReplanMode replan = ReplanMode::ON_TARGET;
+    AssignMode assign = AssignMode::NEGOTIATE;
+    bool cooperative = false;   // reserve (cell, tick) slots so robots never overlap
+    bool flowField = false;     // carrying robots follow the pivot's shared distance field
+    int pivots = 1;             // stacking sites open at once
+    int window = 16;            // cooperative look-ahead in moves
+
+    int tickThreads = 1;        // plan-phase workers per run; 0 -> one per core
+    long long maxTicks = 0;     // 0 -> no limit
+    bool verbose = false;
+
+    std::string metricsPath;    // headless: JSON metrics dump, one object per line
+    long long metricsEvery = 0; // also dump every N ticks; 0 -> at the end only
+
+    std::string tracePath;      // headless: binary event trace for warehouse_replay
+    long long traceKeyframes = 256;     // full-state keyframe every N ticks
+
+    std::string offscreenPath;  // windowed binary: render without a window, save the last frame here
+    int tickRate = 20;          // windowed binary: ticks per second; 0 -> as fast as possible
+};
+
+// Parses --rows, --cols, --robots, --boxes, --wall, --no-walls, --layout, --seed,
+// --planner, --replan, --assign, --cooperative, --flow-field, --pivots, --window,
+// --tick-threads, --max-ticks and --verbose. Returns false and fills `error` on bad input.
+bool parseScenarioArgs(int argc, char** argv, ScenarioConfig& config, std::string& error);
+void printScenarioUsage(std::ostream& out, const char* program);
+
+#endif
@@ -1,21 +1,47 @@
 #pragma once
-#include <mutex>
+#include <atomic>
 #include <chrono>
-#include <vector>
+#include <memory>
 
-#include "Box.hpp"
-#include "Robot.hpp"
+#include "BoxStore.hpp"
+#include "Metrics.hpp"
 
+// Blackboard of one simulation (owned by its SimulationContext): the open
+// pivots, how many boxes are on their way to each, and the run's movement
+// tallies.
+//
+// Nothing here takes a lock. Each pivot slot publishes its box as the handle's
+// key in a single atomic word, so a read is one acquire load, and the handle's
+// generation keeps a pivot that was cleared and whose box slot was reused from
+// passing for the old one. The inbound counts are capacity reservations, kept
+// up to date by the robots as they pick up and stack instead of being
+// recounted. Tallies go to per-thread shards like the Metrics counters and are
+// summed on read.
 class SharedMemory {
 public:
-    static SharedMemory& get();
+    static constexpr int MAX_PIVOTS = 8;
 
-    bool pivotExists() const;
-    void setPivot(Box* value);
-    Box* getPivot() const;
-    void clearPivot();
-    int countBoxesGoingToPivot(const std::vector<Robot*>& robots);
+    // `pivots` slots, clamped to [1, MAX_PIVOTS]
+    explicit SharedMemory(int pivots = 1);
 
+    int pivotSlots() const { return slotCount; }
+    bool pivotExists() const { return openPivots.load(std::memory_order_acquire) != 0; }
+    BoxHandle getPivot(int slot) const {
+        return BoxHandle::fromKey(slots[slot].pivot.load(std::memory_order_acquire));
+    }
+    void setPivot(int slot, BoxHandle value);
+    void clearPivot(int slot);      // also drops the slot's reservations
+
+    int findPivot(BoxHandle handle) const;     // its slot, -1 if it is not an open pivot
+    int freePivotSlot() const;                  // -1 when every slot is open
+
+    // Robots carrying a box toward the pivot in `slot`
+    int boxesGoingToPivot(int slot) const { return slots[slot].inbound.load(std::memory_order_relaxed); }
+    void addBoxesGoingToPivot(int slot, int count) {
+        slots[slot].inbound.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    // Starts the clock and zeroes the tallies; call before the first tick
     void startTimer();
     long long getElapsedTimeMs() const;
 
@@ -23,16 +49,35 @@ public:
     void addMovements(int count);
     int getMovementCount() const;
 
-private:
-    SharedMemory();
+    // Cooperative mode: ticks a robot spent waiting for a reserved cell, and
+    // robots found sharing or swapping cells (should stay 0)
+    void addWaits(int count);
+    void addConflicts(int count);
+    int getWaitCount() const;
+    int getConflictCount() const;
 
     SharedMemory(const SharedMemory&) = delete;
     SharedMemory& operator=(const SharedMemory&) = delete;
 
-    Box* pivot;
+private:
+    struct alignas(64) Tally {
+        std::atomic<int> movements{0};
+        std::atomic<int> waits{0};
+        std::atomic<int> conflicts{0};
+    };
+
+    Tally& local() { return tallies[Metrics::threadShard()]; }
+    int sum(std::atomic<int> Tally::*field) const;
+
+    struct alignas(64) PivotSlot {
+        std::atomic<uint64_t> pivot{0};     // BoxHandle::key(), 0 = none
+        std::atomic<int> inbound{0};
+    };
 
-    mutable std::mutex mtx;
+    int slotCount;
+    PivotSlot slots[MAX_PIVOTS];
+    std::atomic<int> openPivots{0};
 
     std::chrono::steady_clock::time_point startTime;
-    int totalMovements;
-};
\ No newline at end of file
+    std::unique_ptr<Tally[]> tallies;
+};
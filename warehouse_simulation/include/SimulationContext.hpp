@@ -0,0 +1,110 @@
+#ifndef SIMULATIONCONTEXT_HPP
+#define SIMULATIONCONTEXT_HPP
+
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "AgentRegistry.hpp"
+#include "CooperativePlanner.hpp"
+#include "FlowField.hpp"
+#include "Grid.hpp"
+#include "Metrics.hpp"
+#include "PathPlanner.hpp"
+#include "PivotManager.hpp"
+#include "Robot.hpp"
+#include "Scenario.hpp"
+#include "SharedMemory.hpp"
+#include "ThreadPool.hpp"
+#include "Trace.hpp"
+
+// Outcome of one run, as reported by the headless and batch drivers
+struct RunResult {
+    bool completed = false;     // every robot ran out of boxes before maxTicks
+    long long ticks = 0;        // ticks simulated; this is the makespan when completed
+    int movements = 0;
+    long long elapsedMs = 0;
+    int waits = 0;              // cooperative mode only
+    int conflicts = 0;
+};
+
+// Machine-readable reports: one JSON object per line, or CSV rows
+void writeResultJson(std::ostream& out, const ScenarioConfig& config, const RunResult& result);
+void writeResultCsvHeader(std::ostream& out);
+void writeResultCsv(std::ostream& out, const ScenarioConfig& config, const RunResult& result);
+
+// One self-contained simulation: grid, agent registry, pivot state, metrics
+// and robots. Nothing in here is process-wide, so any number of contexts can
+// run side by side on different threads.
+class SimulationContext {
+public:
+    explicit SimulationContext(const ScenarioConfig& config);
+
+    SimulationContext(const SimulationContext&) = delete;
+    SimulationContext& operator=(const SimulationContext&) = delete;
+
+    // Builds walls, boxes and robots from the config. Call once before stepping.
+    bool populate(std::string& error);
+
+    // Advances every robot by one tick: message delivery, allocation, a plan
+    // phase that runs path searches and box queries concurrently against the
+    // unchanged grid, then an act phase that commits moves and grid changes
+    // in robot order. Results do not depend on config.tickThreads.
+    void step();
+
+    // Counts robots that ended the tick on the same cell or swapped cells
+    int countConflicts(const std::vector<int>& before) const;
+
+    // True once every robot has given up searching (the end condition of a run)
+    bool allRobotsIdle() const;
+
+    // True once no box has been lifted, stacked or made a pivot for longer
+    // than any trip across the grid takes: the robots are stuck for good
+    bool stalled() const;
+
+    // Records every following tick into `recorder` (owned by the caller);
+    // writes the layout and first keyframe right away. Call after populate().
+    void attachTrace(TraceRecorder* recorder);
+
+    // Steps until allRobotsIdle(), stalled() or config.maxTicks, calling
+    // afterStep (when set) once each tick has finished
+    RunResult run(const std::function<void()>& afterStep = {});
+    RunResult result() const;
+
+    const ScenarioConfig& getConfig() const { return config; }
+    AgentRegistry& getRegistry() { return registry; }
+    Metrics& getMetrics() { return metrics; }
+    TraceRecorder* getTrace() { return trace; }
+    SharedMemory& getMemory() { return memory; }
+    PivotManager& getPivots() { return pivots; }
+    Grid& getGrid() { return grid; }
+    const PathPlanner& getPlanner() const { return *planner; }
+    CooperativePlanner* getCooperative() { return cooperative.get(); }
+    FlowFieldCache& getFlowFields() { return flowFields; }
+    const std::vector<std::unique_ptr<Robot>>& getRobots() const { return robots; }
+    long long getTick() const { return ticks; }
+
+private:
+    ScenarioConfig config;
+    Metrics metrics;
+    AgentRegistry registry;
+    SharedMemory memory;
+    PivotManager pivots;
+    Grid grid;
+    FlowFieldCache flowFields;                          // observes `grid`, so declared after it
+    std::unique_ptr<PathPlanner> planner;
+    std::unique_ptr<CooperativePlanner> cooperative;    // null unless config.cooperative
+    std::unique_ptr<TaskAllocator> allocator;           // null when robots negotiate
+    std::unique_ptr<ThreadPool> pool;                   // null when the plan phase runs inline
+    std::vector<std::unique_ptr<Robot>> robots;
+    TraceRecorder* trace = nullptr;
+    long long ticks = 0;
+
+    static constexpr long long STALL_TICKS = 1000;  // on top of 4 trips across the grid
+    long long progress = 0;                         // boxes lifted, stacked or promoted
+    long long lastProgressTick = 0;
+};
+
+#endif
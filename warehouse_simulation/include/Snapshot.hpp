@@ -0,0 +1,75 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "Grid.hpp"
+#include "TripleBuffer.hpp"
+
+class SimulationContext;
+
+struct SnapshotRobot {
+    int32_t x, y;
+    int32_t fromX, fromY;       // where it was one tick earlier, to interpolate from
+    bool carrying;
+};
+
+struct SnapshotBox {
+    int32_t cell;               // padded grid index
+    uint8_t height;
+    bool pivot;
+};
+
+// What the viewer needs of one tick: robots and the boxes on the floor.
+// Walls do not change during a run and are read from the grid up front.
+struct Snapshot {
+    long long tick = -1;
+    bool finished = false;      // the simulation thread has stopped
+    std::chrono::steady_clock::time_point publishedAt;
+
+    std::vector<SnapshotRobot> robots;
+    std::vector<SnapshotBox> boxes;     // in cell order
+    uint64_t boxVersion = 0;            // changes whenever `boxes` does
+};
+
+// Publishes a Snapshot after every tick for a viewer on another thread,
+// through a TripleBuffer: the simulation never waits for the viewer and the
+// viewer always gets the newest complete tick. The box list is maintained
+// from the grid's change notifications and the pivots, so a tick costs the
+// robots plus the boxes that changed, and the list is only copied into a slot
+// that holds an older version of it.
+class SnapshotPublisher : public GridObserver {
+public:
+    // Captures the state as it is now, before the simulation thread starts
+    explicit SnapshotPublisher(SimulationContext& sim);
+    ~SnapshotPublisher() override;
+
+    SnapshotPublisher(const SnapshotPublisher&) = delete;
+    SnapshotPublisher& operator=(const SnapshotPublisher&) = delete;
+
+    // Simulation thread, after each step()
+    void publish(bool finished = false);
+
+    // Viewer thread: fetch() swaps in the newest snapshot, if any
+    bool fetch() { return buffer.fetch(); }
+    const Snapshot& latest() const { return buffer.front(); }
+
+    void onCellChanged(int idx) override;
+
+private:
+    void applyChanges();
+
+    SimulationContext& sim;
+    TripleBuffer<Snapshot> buffer;
+
+    std::vector<SnapshotBox> boxes;     // current, in cell order
+    uint64_t boxVersion = 1;
+    std::vector<int> changed;           // cells since the last publish, may repeat
+    std::vector<BoxHandle> pivots;      // by blackboard slot
+    std::vector<int> pivotCells;        // -1 for an empty slot
+    std::vector<SnapshotRobot> robots;
+};
+
+#endif
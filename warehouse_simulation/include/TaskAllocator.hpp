@@ -0,0 +1,110 @@
+#ifndef TASKALLOCATOR_HPP
+#define TASKALLOCATOR_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "FlowField.hpp"
+#include "Grid.hpp"
+
+class Robot;
+
+enum class AssignMode {
+    NEGOTIATE,  // each robot picks the nearest box and asks its peers over ACL
+    AUTO,       // Hungarian for small fleets, auction for large ones
+    HUNGARIAN,
+    AUCTION
+};
+
+bool parseAssignMode(const std::string& text, AssignMode& mode);
+const char* assignModeName(AssignMode mode);
+
+using CostMatrix = std::vector<std::vector<long long>>;
+
+// Minimum-cost assignment of rows to columns (O(n^2 m)). Returns the column of
+// each row, or -1 for rows left over when there are more rows than columns.
+std::vector<int> solveHungarian(const CostMatrix& cost);
+
+// (column, cost) pairs of each row; a row may only take a column it lists
+using SparseCosts = std::vector<std::vector<std::pair<int, long long>>>;
+
+// Forward auction with unit bid increments over sparse rows, so the total
+// cost is within one per row of the best assignment that keeps to the listed
+// columns. With `slack` >= 0 a row may also go without, at `slack` more than
+// its dearest column; with -1 it may not, and every row must be able to get a
+// column. Returns the column of each row, -1 for rows that went without.
+//
+// Column prices are remembered under the caller's keys (0 = do not remember)
+// and reused by the next call, so a round over a mostly unchanged set of
+// columns starts where the last one stopped. They are shifted down to a
+// minimum of zero first. The bound also needs every column left over to cost
+// no more than the cheapest one taken, which a carried price can break; the
+// call then starts over from zero prices.
+class AuctionSolver {
+public:
+    std::vector<int> solve(const SparseCosts& rows, size_t columns,
+                           const std::vector<uint64_t>& keys, long long slack);
+    void forget(uint64_t key) { prices.erase(key); }
+
+private:
+    // One forward auction from `price`; false if it leaves a column over that
+    // is dearer than the cheapest one taken
+    bool bid(const SparseCosts& rows, long long slack, std::vector<long long>& price,
+             std::vector<int>& colOf) const;
+
+    std::unordered_map<uint64_t, long long> prices;
+};
+
+// The auction on a full matrix, from zero prices. Same result convention as
+// solveHungarian.
+std::vector<int> solveAuction(const CostMatrix& cost);
+
+// The allocation stage: once per tick, before the robots act, every robot that
+// is free for a new box gets one. Costs are grid path lengths from the robot to
+// the box plus the box's leg to the nearest pivot, so a box close to a robot
+// but far from every pivot can lose to a slightly further one on the way. The
+// legs are read from the pivots' flow fields, which the carrying robots share.
+// Hungarian prices every box for every robot. The auction only prices each
+// robot's AUCTION_CANDIDATES nearest open boxes, so its searches stop once
+// those are reached; a robot outbid on all of them waits for the next tick.
+class TaskAllocator {
+public:
+    explicit TaskAllocator(AssignMode mode);
+
+    // Returns how many robots received a box. `toPivots` holds the field of
+    // every open pivot, none before the first.
+    int allocate(const Grid& grid, const std::vector<std::unique_ptr<Robot>>& robots,
+                 const std::vector<FlowField*>& toPivots);
+
+    static constexpr int HUNGARIAN_LIMIT = 32;     // AUTO switches to the auction above this fleet size
+    static constexpr int AUCTION_CANDIDATES = 16;  // boxes the auction prices per robot
+
+private:
+    // Breadth-first distances from `source`; box cells are reached but not
+    // walked through. Stops early once every cell in `targets` has a distance.
+    void distancesFrom(const Grid& grid, int source, const std::vector<int>& targets);
+    int distanceTo(int idx) const { return stamp[idx] == generation ? dist[idx] : -1; }
+
+    // Box column for each free robot, -1 for none
+    std::vector<int> chooseByHungarian(const Grid& grid, const std::vector<Robot*>& free,
+                                       const std::vector<int>& cells, const std::vector<long long>& leg);
+    std::vector<int> chooseByAuction(const Grid& grid, const std::vector<Robot*>& free,
+                                     const std::vector<BoxHandle>& boxes, const std::vector<int>& cells,
+                                     const std::vector<long long>& leg);
+
+    AssignMode mode;
+    AuctionSolver auction;
+
+    uint32_t generation = 0;
+    std::vector<uint32_t> stamp;
+    std::vector<int> dist;
+    std::vector<int> queue;
+    std::vector<uint32_t> wanted;       // == generation for target cells not reached yet
+    std::vector<int> columnAt;          // open box column by cell, -1 elsewhere
+};
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads, each with its own task deque. A worker takes
+// from the back of its own deque and, when that runs dry, steals from the
+// front of the others', so a burst of small tasks (one tick's plan phase)
+// spreads over every core without all of them fighting over one queue.
+class ThreadPool {
+public:
+    // 0 threads -> one per hardware core
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+
+    // Runs body(i) for every i in [0, count) and returns once all calls are done.
+    // Must not be called from inside a task.
+    void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+    // Blocks until every submitted task has finished
+    void wait();
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+private:
+    struct Queue {
+        std::mutex mtx;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool tryTake(unsigned self, std::function<void()>& task);
+    void workerLoop(unsigned self);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<unsigned> nextQueue{0};
+    std::atomic<long> queued{0};        // sitting in some deque
+    std::atomic<long> pending{0};       // submitted and not finished yet
+
+    std::mutex mtx;                     // sleeping workers and wait()
+    std::condition_variable taskReady;
+    std::condition_variable allDone;
+    bool stopping = false;
+};
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ACLMessage.hpp"
+
+class SimulationContext;
+
+// Binary event trace of one run.
+//
+// The file starts with the layout (grid size, seed, wall bitmap), followed by
+// a keyframe holding the full state after populate() and then one block per
+// tick: robot moves, pickups, stacks, pivot changes and the messages
+// delivered that tick. Blocks are length-prefixed and their contents are
+// delta-encoded as LEB128 varints, so an idle tick costs five bytes and a
+// move usually one more. Every keyframeEvery ticks another full keyframe
+// follows the tick block, and an index of all keyframes closes the file, so
+// a replayer can reach any tick by loading the keyframe before it and
+// applying at most keyframeEvery tick blocks.
+//
+// A trace cut short (the run crashed or was killed) is still readable up to
+// its last complete block; the keyframe index is then rebuilt by a scan.
+
+// One cell of the replayed floor: stack height, 0 when empty
+struct TraceCell {
+    uint8_t height = 0;
+    bool pivot = false;
+};
+
+struct TraceRobot {
+    int x = 0, y = 0;
+    bool carrying = false;
+};
+
+enum class TraceEventKind : uint8_t {
+    PICK = 1,       // robot lifted the box at cell
+    STACK,          // robot merged its box into the stack at cell, now `height` tall
+    PIVOT_ON,       // the box at cell became a pivot
+    PIVOT_OFF,
+};
+
+struct TraceEvent {
+    TraceEventKind kind;
+    acl::AgentId robot = acl::NO_AGENT;     // PICK and STACK only
+    int x = 0, y = 0;
+    int height = 0;                         // STACK only
+};
+
+// State of the floor as of the end of a tick
+struct TraceState {
+    long long tick = 0;
+    int rows = 0, cols = 0;
+    std::vector<bool> walls;                // y * cols + x
+    std::vector<TraceCell> cells;           // y * cols + x
+    std::vector<TraceRobot> robots;         // by AgentId
+
+    // What happened during this tick (nothing for tick 0, the populated layout)
+    std::vector<TraceEvent> events;
+    std::vector<acl::ACLMessage> messages;
+};
+
+// Writes the trace of one SimulationContext. The context calls begin() once
+// populated, endTick() after every step() and finish() when it is done;
+// robots report their pickups, stacks and pivot changes as they commit them.
+class TraceRecorder {
+public:
+    TraceRecorder(std::ostream& out, int keyframeEvery);
+
+    void begin(SimulationContext& context);
+
+    // Act-phase events, in the order they are committed
+    void pick(acl::AgentId robot, int x, int y);
+    void stack(acl::AgentId robot, int x, int y, int height);
+    void pivot(int x, int y, bool on);
+
+    void endTick(SimulationContext& context);
+
+    // Writes the keyframe index; the trace is complete without it, only slower to open
+    void finish();
+
+private:
+    void writeKeyframe(SimulationContext& context);
+    void flush();
+
+    std::ostream& out;
+    int keyframeEvery;
+    int cols = 0;
+    long long written = 0;                  // bytes so far
+    std::vector<uint8_t> buffer;            // block being built
+    std::vector<uint8_t> events;            // this tick's events, encoded
+    uint32_t eventCount = 0;
+    std::vector<std::pair<int, int>> lastPositions;
+    std::vector<std::pair<long long, long long>> keyframes;     // (tick, offset)
+    bool finished = false;
+};
+
+// Rebuilds any tick of a recorded run without re-running the simulation
+class TraceReplayer {
+public:
+    // Loads the whole file; false with a reason when it is not a trace
+    bool open(const std::string& path, std::string& error);
+
+    long long lastTick() const { return last; }
+    unsigned seed() const { return runSeed; }
+    int keyframeInterval() const { return keyframeEvery; }
+
+    // Moves to the end of `tick` (clamped to the recorded range)
+    void seek(long long tick);
+
+    // Applies the next tick block; false at the end of the trace
+    bool next();
+
+    const TraceState& state() const { return current; }
+
+private:
+    bool readHeader(std::string& error);
+    void indexKeyframes();
+    bool readKeyframe(size_t& pos, TraceState& into) const;
+    bool applyTick(size_t& pos, TraceState& into) const;
+
+    std::vector<uint8_t> data;
+    size_t body = 0;                        // offset of the first block
+    unsigned runSeed = 0;
+    int keyframeEvery = 0;
+    long long last = 0;
+    std::vector<std::pair<long long, size_t>> keyframes;
+    TraceState layout;                      // walls and dimensions only
+    TraceState current;
+    size_t cursor = 0;                      // next block after current.tick
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef TRIPLEBUFFER_HPP
+#define TRIPLEBUFFER_HPP
+
+#include <atomic>
+#include <cstdint>
+
+// Single-producer, single-consumer hand-off of the latest value. Of the three
+// slots the producer owns one (back), the consumer owns one (front) and the
+// third (middle) is in flight; publishing and fetching each swap their own
+// slot with the middle one in a single atomic exchange. Neither side ever
+// waits for the other: the producer overwrites a value the consumer has not
+// fetched yet, and the consumer keeps its current value when nothing new
+// arrived.
+//
+// Slots are reused, never cleared: back() still holds whatever was written
+// there two publishes ago, which lets the producer skip rewriting parts that
+// did not change since.
+template <class T>
+class TripleBuffer {
+public:
+    // Producer side
+    T& back() { return slots[backIndex]; }
+    void publish() {
+        uint8_t old = middle.exchange(static_cast<uint8_t>(backIndex | FRESH), std::memory_order_acq_rel);
+        backIndex = old & INDEX;
+    }
+
+    // Consumer side. Swaps in the newest published value, if any; true if
+    // front() changed.
+    bool fetch() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH))
+            return false;
+        uint8_t old = middle.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = old & INDEX;
+        return true;
+    }
+    const T& front() const { return slots[frontIndex]; }
+
+private:
+    static constexpr uint8_t INDEX = 3;
+    static constexpr uint8_t FRESH = 4;     // middle holds a value not yet fetched
+
+    T slots[3];
+    alignas(64) std::atomic<uint8_t> middle{1};
+    alignas(64) uint8_t backIndex = 0;      // producer only
+    alignas(64) uint8_t frontIndex = 2;     // consumer only
+};
+
+#endif
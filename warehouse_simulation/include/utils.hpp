@@ -3,8 +3,8 @@
 #include "Grid.hpp"
 
 
-using Pos = std::pair<int,int>;
-
-std::vector<Pos> computeDijkstraPath(const Grid& grid, int startX, int startY, int targetX, int targetY);
+// `expanded`, when given, receives the number of cells settled
+std::vector<Pos> computeDijkstraPath(const Grid& grid, int startX, int startY, int targetX, int targetY,
+                                     int* expanded = nullptr);
 
 #endif
\ No newline at end of file
@@ -1,51 +1,54 @@
 #include "Agent.hpp"
 #include "AgentRegistry.hpp"
 
-#include <random>
-#include <sstream>
-#include <chrono>
+#include <algorithm>
 
-Agent::Agent(const std::string& name) : name(name) {
-    AgentRegistry::registerAgent(name, this);
+Agent::Agent(const std::string& name, AgentRegistry& registry)
+: name(name), registry(registry), negotiations(*this) {
+    id = registry.registerAgent(name, this);
 }
 
-void Agent::send(const std::string& receiverName, const acl::ACLMessage& msg) {
-    Agent* receiver = AgentRegistry::getAgent(receiverName);
-    if (!receiver) {
-        std::cerr << "ERROR: Agent '" << receiverName << "' not found!\n";
-        return;
-    }
-    receiver->receive(msg);
+void Agent::send(acl::AgentId receiver, const acl::ACLMessage& msg) {
+    outbox.push_back({Audience::ONE, receiver, msg});
+    outbox.back().msg.receiver = receiver;
 }
 
-std::string Agent::generateUniqueConversationId() {
-    auto now = std::chrono::system_clock::now().time_since_epoch();
-    auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+int Agent::broadcast(const acl::ACLMessage& msg) {
+    outbox.push_back({Audience::ALL, 0, msg});
+    outbox.back().msg.receiver = acl::NO_AGENT;
+    return static_cast<int>(registry.agentCount()) - 1;
+}
+
+int Agent::multicast(acl::GroupId group, const acl::ACLMessage& msg) {
+    outbox.push_back({Audience::GROUP, group, msg});
+    outbox.back().msg.receiver = acl::NO_AGENT;
 
-    static std::mt19937 rng(std::random_device{}());
-    static std::uniform_int_distribution<int> dist(0, 9999);
+    const std::vector<acl::AgentId>& members = registry.groupMembers(group);
+    int count = static_cast<int>(members.size());
+    if (std::find(members.begin(), members.end(), id) != members.end())
+        count--;
+    return count;
+}
 
-    std::stringstream ss;
-    ss << "conv-" << millis << "-" << dist(rng);
-    return ss.str();
+void Agent::processInbox(const std::vector<acl::ACLMessage>& mail) {
+    // Swap first: replies sent from receive() must wait for the next phase
+    processing.swap(inbox);
+    for (uint32_t slot : processing)
+        receive(mail[slot]);
+    processing.clear();
 }
 
-void Agent::sendRequest(const std::string& receiver, const std::string& content, const std::string& convId) {
+void Agent::sendRequest(acl::AgentId receiver, const acl::Content& content, acl::ConversationId convId) {
     acl::ACLMessage req(
         acl::Performative::REQUEST,
-        name,
+        id,
         receiver,
         content,
-        "SL",
-        "warehouse-ontology",
-        "fipa-contract-net",
+        acl::Language::SL,
+        acl::Ontology::WAREHOUSE,
+        acl::Protocol::FIPA_CONTRACT_NET,
         convId
     );
 
     send(receiver, req);
 }
-
-bool Agent::hasResponseArrived(const std::string& conversationId) {
-    auto it = pendingRequests.find(conversationId);
-    return it != pendingRequests.end() && it->second;
-}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include "BoxIndex.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+BoxIndex::BoxIndex(const BoxStore& store, int rows, int cols)
+: store(store), tilesX((cols + TILE - 1) / TILE), tilesY((rows + TILE - 1) / TILE)
+{
+    tiles.resize(static_cast<size_t>(std::max(tilesX, 1)) * std::max(tilesY, 1));
+}
+
+void BoxIndex::insert(BoxHandle box) {
+    const Box* b = store.get(box);
+    tiles[tileOf(b->x, b->y)].push_back(box);
+    count++;
+}
+
+void BoxIndex::remove(BoxHandle box) {
+    const Box* b = store.get(box);
+    std::vector<BoxHandle>& tile = tiles[tileOf(b->x, b->y)];
+    auto it = std::find(tile.begin(), tile.end(), box);
+    if (it == tile.end()) return;
+    *it = tile.back();
+    tile.pop_back();
+    count--;
+}
+
+int BoxIndex::nearest(int x, int y, int k, const BoxFilter& filter, std::vector<BoxHandle>& out) const {
+    struct Candidate {
+        int dist;
+        int y, x;
+        BoxHandle box;
+        bool operator<(const Candidate& o) const {
+            if (dist != o.dist) return dist < o.dist;
+            return y != o.y ? y < o.y : x < o.x;
+        }
+    };
+
+    out.clear();
+    if (k <= 0 || count == 0) return 0;
+
+    std::vector<Candidate> found;
+    const int tx = x / TILE;
+    const int ty = y / TILE;
+    const int maxRing = std::max(tilesX, tilesY);
+
+    auto visit = [&](int cx, int cy) {
+        if (cx < 0 || cy < 0 || cx >= tilesX || cy >= tilesY) return;
+        for (BoxHandle handle : tiles[cy * tilesX + cx]) {
+            const Box& box = *store.get(handle);
+            if (box.stackSize >= filter.maxStack) continue;
+            if (filter.skipPivots && box.isPivot) continue;
+            if (filter.accept && !filter.accept(handle, box)) continue;
+            found.push_back({std::abs(box.x - x) + std::abs(box.y - y), box.y, box.x, handle});
+        }
+    };
+
+    for (int ring = 0; ring <= maxRing; ring++) {
+        if (ring == 0) {
+            visit(tx, ty);
+        } else {
+            for (int dx = -ring; dx <= ring; dx++) {
+                visit(tx + dx, ty - ring);
+                visit(tx + dx, ty + ring);
+            }
+            for (int dy = -ring + 1; dy < ring; dy++) {
+                visit(tx - ring, ty + dy);
+                visit(tx + ring, ty + dy);
+            }
+        }
+
+        // Every cell in a later ring is at least ring * TILE + 1 away
+        int settled = 0;
+        for (const Candidate& c : found)
+            if (c.dist <= ring * TILE) settled++;
+        if (settled >= k) break;
+    }
+
+    std::sort(found.begin(), found.end());
+    int n = std::min<int>(k, static_cast<int>(found.size()));
+    for (int i = 0; i < n; i++)
+        out.push_back(found[i].box);
+    return n;
+}
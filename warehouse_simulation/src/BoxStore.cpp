@@ -0,0 +1,44 @@
+#include "BoxStore.hpp"
+
+void BoxStore::reserve(size_t count) {
+    items.reserve(count);
+    owners.reserve(count);
+    slots.reserve(count);
+}
+
+BoxHandle BoxStore::create(int x, int y, int stackSize) {
+    uint32_t slot;
+    if (freeHead != NO_SLOT) {
+        slot = freeHead;
+        freeHead = slots[slot].dense;
+    } else {
+        slot = static_cast<uint32_t>(slots.size());
+        slots.push_back({0, 1});
+    }
+
+    slots[slot].dense = static_cast<uint32_t>(items.size());
+    items.emplace_back(x, y, stackSize);
+    owners.push_back(slot);
+    return {slot, slots[slot].generation};
+}
+
+void BoxStore::destroy(BoxHandle handle) {
+    if (!contains(handle)) return;
+
+    // Move the last box into the hole to keep the array dense
+    uint32_t hole = slots[handle.slot].dense;
+    uint32_t last = static_cast<uint32_t>(items.size() - 1);
+    if (hole != last) {
+        items[hole] = items[last];
+        owners[hole] = owners[last];
+        slots[owners[hole]].dense = hole;
+    }
+    items.pop_back();
+    owners.pop_back();
+
+    // Retire the handle; generation 0 is reserved for "no box"
+    Slot& slot = slots[handle.slot];
+    if (++slot.generation == 0) slot.generation = 1;
+    slot.dense = freeHead;
+    freeHead = handle.slot;
+}
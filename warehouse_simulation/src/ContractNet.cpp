@@ -0,0 +1,118 @@
+#include "ContractNet.hpp"
+#include "Agent.hpp"
+
+namespace acl {
+
+ContractNet::ContractNet(Agent& owner, size_t capacity)
+: owner(owner), slots(capacity) {}
+
+ContractNet::Slot* ContractNet::find(ConversationId id) {
+    Slot& slot = slots[static_cast<uint32_t>(id) % slots.size()];
+    return slot.open && slot.negotiation.id == id ? &slot : nullptr;
+}
+
+const ContractNet::Slot* ContractNet::find(ConversationId id) const {
+    const Slot& slot = slots[static_cast<uint32_t>(id) % slots.size()];
+    return slot.open && slot.negotiation.id == id ? &slot : nullptr;
+}
+
+ConversationId ContractNet::callForProposals(const Content& task, long long now, long long deadline, Completion done) {
+    if (openCount == static_cast<int>(slots.size())) return 0;
+
+    // Skip ahead to the next free slot; the table is not full, so one exists
+    do {
+        counter++;
+    } while (counter == 0 || slots[counter % slots.size()].open);
+
+    Slot& slot = slots[counter % slots.size()];
+    Negotiation& n = slot.negotiation;
+    n.id = (static_cast<ConversationId>(owner.getId()) << 32) | counter;
+    n.task = task;
+    n.started = now;
+    n.deadline = deadline;
+    n.refusals = 0;
+    n.proposals.clear();        // keeps its capacity for the next round
+    slot.done = std::move(done);
+    slot.open = true;
+    openCount++;
+
+    ACLMessage cfp(
+        Performative::CFP,
+        owner.getId(),
+        NO_AGENT,
+        task,
+        Language::SL,
+        Ontology::WAREHOUSE,
+        Protocol::FIPA_CONTRACT_NET,
+        n.id
+    );
+    n.awaiting = owner.broadcast(cfp);
+    return n.id;
+}
+
+void ContractNet::cancel(ConversationId id) {
+    if (Slot* slot = find(id)) {
+        slot->open = false;
+        slot->done = nullptr;
+        openCount--;
+    }
+}
+
+void ContractNet::update(long long now) {
+    if (openCount == 0) return;
+
+    for (Slot& slot : slots) {
+        if (!slot.open) continue;
+        const Negotiation& n = slot.negotiation;
+        if (n.awaiting > 0 && now < n.deadline) continue;
+
+        // The slot stays open while the callback runs, so a CFP started from
+        // it cannot land on top of the negotiation it is reading
+        Completion done = std::move(slot.done);
+        if (done) done(n);
+        if (slot.open) {        // unless the callback cancelled it
+            slot.open = false;
+            openCount--;
+        }
+    }
+}
+
+bool ContractNet::handleReply(const ACLMessage& msg) {
+    Slot* slot = find(msg.conversationId);
+    if (!slot) return false;
+
+    Negotiation& n = slot->negotiation;
+    if (msg.performative == Performative::PROPOSE)
+        n.proposals.push_back({msg.sender, msg.content});
+    else if (msg.performative == Performative::REFUSE)
+        n.refusals++;
+    else
+        return false;
+
+    if (n.awaiting > 0) n.awaiting--;
+    return true;
+}
+
+void ContractNet::reply(const ACLMessage& to, Performative performative, const Content& content) {
+    ACLMessage msg(
+        performative,
+        owner.getId(),
+        to.sender,
+        content,
+        to.language,
+        to.ontology,
+        to.protocol,
+        to.conversationId
+    );
+    owner.send(to.sender, msg);
+}
+
+void ContractNet::propose(const ACLMessage& cfp, const Content& bid) {
+    reply(cfp, Performative::PROPOSE, bid);
+}
+
+void ContractNet::refuse(const ACLMessage& cfp) {
+    reply(cfp, Performative::REFUSE, std::monostate());
+}
+
+} // namespace acl
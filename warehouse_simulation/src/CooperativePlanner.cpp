@@ -0,0 +1,123 @@
+#include "CooperativePlanner.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <unordered_set>
+
+namespace {
+
+struct Node {
+    int idx;
+    int dt;
+    int parent;
+};
+
+struct OpenEntry {
+    int f;
+    int dt;
+    int node;
+};
+
+bool openAfter(const OpenEntry& a, const OpenEntry& b) {
+    // Min-heap on f; on ties prefer the node further along in time
+    if (a.f != b.f) return a.f > b.f;
+    return a.dt < b.dt;
+}
+
+} // namespace
+
+CooperativePlanner::CooperativePlanner(int cellCount, int window)
+: windowSize(std::max(window, 1)), reservations(cellCount) {}
+
+WindowOutcome CooperativePlanner::plan(const Grid& grid, const Robot* self, Pos startPos, long long tick,
+                                       Pos waypointPos, int radius, std::vector<Pos>& steps,
+                                       SearchStats* stats) const {
+    steps.clear();
+
+    const int start = grid.index(startPos.first, startPos.second);
+    const int* offsets = grid.neighborOffsets();
+    const int maxDt = 2 * windowSize;
+    const int budget = 16 * windowSize * windowSize;
+    const uint64_t cells = static_cast<uint64_t>(grid.cellCount());
+
+    auto heuristic = [&](int idx) {
+        int d = std::abs(grid.xOf(idx) - waypointPos.first) + std::abs(grid.yOf(idx) - waypointPos.second);
+        return std::max(d - radius, 0);
+    };
+
+    std::vector<Node> nodes;
+    std::vector<OpenEntry> open;
+    std::unordered_set<uint64_t> closed;
+
+    nodes.push_back({start, 0, -1});
+    open.push_back({heuristic(start), 0, 0});
+
+    int goalNode = -1;
+    int fallback = -1;
+    int fallbackH = 0;
+    int expanded = 0;
+
+    while (!open.empty() && expanded < budget) {
+        std::pop_heap(open.begin(), open.end(), openAfter);
+        OpenEntry e = open.back();
+        open.pop_back();
+
+        const Node cur = nodes[e.node];
+        if (!closed.insert(static_cast<uint64_t>(cur.dt) * cells + cur.idx).second) continue;
+        expanded++;
+
+        const long long t = tick + cur.dt;
+        const int h = heuristic(cur.idx);
+
+        if (h == 0 && reservations.canPark(cur.idx, t, self)) {
+            goalNode = e.node;
+            break;
+        }
+        // Closest cell we could stop on, in case the waypoint is out of reach
+        if ((fallback < 0 || h < fallbackH ||
+             (h == fallbackH && cur.dt < nodes[fallback].dt)) &&
+            reservations.canPark(cur.idx, t, self)) {
+            fallback = e.node;
+            fallbackH = h;
+        }
+
+        if (cur.dt >= maxDt) continue;
+
+        // Four moves and a wait
+        for (int i = 0; i <= 4; i++) {
+            int next = (i < 4) ? cur.idx + offsets[i] : cur.idx;
+            if (grid.isBlocked(next)) continue;
+            if (!reservations.isFree(next, t + 1, self)) continue;
+            if (reservations.swapConflict(cur.idx, next, t, self)) continue;
+            if (closed.count(static_cast<uint64_t>(cur.dt + 1) * cells + next)) continue;
+
+            nodes.push_back({next, cur.dt + 1, e.node});
+            open.push_back({cur.dt + 1 + heuristic(next), cur.dt + 1, static_cast<int>(nodes.size()) - 1});
+            std::push_heap(open.begin(), open.end(), openAfter);
+        }
+    }
+
+    if (stats) stats->expanded = expanded;
+
+    int end = goalNode >= 0 ? goalNode : fallback;
+    if (end < 0)
+        return WindowOutcome::BLOCKED;
+
+    for (int n = end; nodes[n].parent >= 0; n = nodes[n].parent)
+        steps.push_back({grid.xOf(nodes[n].idx), grid.yOf(nodes[n].idx)});
+    std::reverse(steps.begin(), steps.end());
+
+    return goalNode >= 0 ? WindowOutcome::REACHED : WindowOutcome::PARTIAL;
+}
+
+void CooperativePlanner::commit(const Grid& grid, const Robot* self, Pos start, long long tick,
+                                const std::vector<Pos>& steps) {
+    int cell = grid.index(start.first, start.second);
+    reservations.reserve(cell, tick, self);
+
+    for (size_t i = 0; i < steps.size(); i++) {
+        cell = grid.index(steps[i].first, steps[i].second);
+        reservations.reserve(cell, tick + 1 + static_cast<long long>(i), self);
+    }
+    reservations.park(cell, tick + static_cast<long long>(steps.size()), self);
+}
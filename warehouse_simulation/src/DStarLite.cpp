@@ -0,0 +1,191 @@
+#include "DStarLite.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+DStarLite::DStarLite(Grid& grid) : grid(grid) {
+    grid.addObserver(this);
+}
+
+DStarLite::~DStarLite() {
+    grid.removeObserver(this);
+}
+
+void DStarLite::onCellChanged(int idx) {
+    // Nothing to repair before the first search
+    if (goal >= 0)
+        changed.push_back(idx);
+}
+
+void DStarLite::setG(int idx, int value) {
+    if (stamp[idx] != generation) {
+        stamp[idx] = generation;
+        rhsScore[idx] = INF;
+    }
+    gScore[idx] = value;
+}
+
+void DStarLite::setRhs(int idx, int value) {
+    if (stamp[idx] != generation) {
+        stamp[idx] = generation;
+        gScore[idx] = INF;
+    }
+    rhsScore[idx] = value;
+}
+
+bool DStarLite::passable(int idx) const {
+    return !grid.isWall(idx) && (!grid.hasBox(idx) || idx == goal);
+}
+
+int DStarLite::heuristic(int a, int b) const {
+    int stride = grid.rowStride();
+    return std::abs(a % stride - b % stride) + std::abs(a / stride - b / stride);
+}
+
+DStarLite::Key DStarLite::keyOf(int idx) const {
+    int best = std::min(g(idx), rhs(idx));
+    return {best + heuristic(start, idx) + km, best};
+}
+
+bool DStarLite::queueAfter(const QueueEntry& a, const QueueEntry& b) {
+    return b.key < a.key;
+}
+
+void DStarLite::push(int idx) {
+    queue.push_back({keyOf(idx), idx});
+    std::push_heap(queue.begin(), queue.end(), queueAfter);
+}
+
+void DStarLite::reset(int newGoal) {
+    if (static_cast<int>(stamp.size()) < grid.cellCount()) {
+        stamp.assign(grid.cellCount(), 0);
+        gScore.resize(grid.cellCount());
+        rhsScore.resize(grid.cellCount());
+        generation = 0;
+    }
+    if (++generation == 0) {
+        std::fill(stamp.begin(), stamp.end(), 0);
+        generation = 1;
+    }
+
+    goal = newGoal;
+    km = 0;
+    queue.clear();
+    changed.clear();
+
+    setRhs(goal, 0);
+    push(goal);
+}
+
+void DStarLite::updateVertex(int idx) {
+    if (idx != goal) {
+        int best = INF;
+        if (passable(idx)) {
+            const int* offsets = grid.neighborOffsets();
+            for (int i = 0; i < 4; i++) {
+                int next = idx + offsets[i];
+                if (passable(next))
+                    best = std::min(best, g(next) + 1);
+            }
+        }
+        setRhs(idx, std::min(best, INF));
+    }
+    if (g(idx) != rhs(idx))
+        push(idx);
+}
+
+int DStarLite::computeShortestPath() {
+    const int* offsets = grid.neighborOffsets();
+    int expanded = 0;
+
+    while (!queue.empty()) {
+        QueueEntry top = queue.front();
+        // Consistent cells left behind by an earlier push
+        if (g(top.idx) == rhs(top.idx)) {
+            std::pop_heap(queue.begin(), queue.end(), queueAfter);
+            queue.pop_back();
+            continue;
+        }
+        if (!(top.key < keyOf(start)) && rhs(start) == g(start))
+            break;
+
+        std::pop_heap(queue.begin(), queue.end(), queueAfter);
+        queue.pop_back();
+
+        Key current = keyOf(top.idx);
+        if (top.key < current) {
+            // km grew since this entry was queued
+            queue.push_back({current, top.idx});
+            std::push_heap(queue.begin(), queue.end(), queueAfter);
+            continue;
+        }
+
+        expanded++;
+        if (g(top.idx) > rhs(top.idx)) {
+            setG(top.idx, rhs(top.idx));
+        } else {
+            setG(top.idx, INF);
+            updateVertex(top.idx);
+        }
+        for (int i = 0; i < 4; i++)
+            updateVertex(top.idx + offsets[i]);
+    }
+    return expanded;
+}
+
+bool DStarLite::plan(Pos startPos, Pos goalPos, std::vector<Pos>& path, SearchStats* stats) {
+    path.clear();
+    if (!grid.inBounds(startPos.first, startPos.second) || !grid.inBounds(goalPos.first, goalPos.second))
+        return false;
+
+    int newStart = grid.index(startPos.first, startPos.second);
+    int newGoal = grid.index(goalPos.first, goalPos.second);
+
+    if (newGoal != goal) {
+        start = newStart;
+        reset(newGoal);
+    } else {
+        // The robot moved: keys already queued stay valid lower bounds
+        km += heuristic(start, newStart);
+        start = newStart;
+
+        std::sort(changed.begin(), changed.end());
+        changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+        // A changed cell alters the cost of every edge touching it
+        const int* offsets = grid.neighborOffsets();
+        for (int idx : changed) {
+            updateVertex(idx);
+            for (int i = 0; i < 4; i++)
+                updateVertex(idx + offsets[i]);
+        }
+        changed.clear();
+    }
+
+    int expanded = computeShortestPath();
+    if (stats) stats->expanded = expanded;
+
+    if (g(start) >= INF || start == goal)
+        return false;
+
+    // Follow the steepest descent of g back to the goal
+    const int* offsets = grid.neighborOffsets();
+    for (int cur = start; cur != goal; ) {
+        int next = -1;
+        int best = INF;
+        for (int i = 0; i < 4; i++) {
+            int n = cur + offsets[i];
+            if (passable(n) && g(n) < best) {
+                best = g(n);
+                next = n;
+            }
+        }
+        if (next < 0 || best >= g(cur)) {
+            path.clear();
+            return false;
+        }
+        path.push_back({grid.xOf(next), grid.yOf(next)});
+        cur = next;
+    }
+    return true;
+}
@@ -0,0 +1,169 @@
+#include "FlowField.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+
+FlowField::FlowField(Grid& grid, int target, Metrics* metrics)
+    : grid(grid), goal(target), metrics(metrics) {
+    build();
+    grid.addObserver(this);
+}
+
+FlowField::~FlowField() {
+    grid.removeObserver(this);
+}
+
+void FlowField::onCellChanged(int idx) {
+    if (rebuildDue) return;
+
+    // A field nobody reads for a while (the last pivot's, until it is
+    // dropped) gets rebuilt on its next lookup instead of replaying a backlog
+    changed.push_back(idx);
+    if (changed.size() > dist.size() / 8) {
+        changed.clear();
+        rebuildDue = true;
+    }
+}
+
+void FlowField::build() {
+    int count = grid.cellCount();
+    dist.resize(count);
+    for (int idx = 0; idx < count; idx++)
+        dist[idx] = grid.isBlocked(idx) ? BLOCKED : FAR;
+
+    std::vector<int> queue = {goal};
+    dist[goal] = 0;
+    const int* offsets = grid.neighborOffsets();
+    for (size_t head = 0; head < queue.size(); head++) {
+        int cur = queue[head];
+        for (int i = 0; i < 4; i++) {
+            int next = cur + offsets[i];
+            if (dist[next] != FAR) continue;
+            dist[next] = dist[cur] + 1;
+            queue.push_back(next);
+        }
+    }
+    if (metrics) metrics->add(Counter::FIELD_BUILDS);
+}
+
+void FlowField::repair() {
+    if (rebuildDue) {
+        rebuildDue = false;
+        build();
+        return;
+    }
+    if (changed.empty()) return;
+
+    const int* offsets = grid.neighborOffsets();
+    std::vector<int> check;     // may have lost the neighbour they counted from
+    std::vector<int> reseed;    // free cells whose distance has to be worked out again
+
+    for (int idx : changed) {
+        if (idx == goal) continue;
+        bool blocked = grid.isBlocked(idx);
+        if (blocked == (dist[idx] == BLOCKED)) continue;
+
+        if (blocked) {
+            dist[idx] = BLOCKED;
+            for (int i = 0; i < 4; i++)
+                check.push_back(idx + offsets[i]);
+        } else {
+            dist[idx] = FAR;
+            reseed.push_back(idx);
+        }
+    }
+    changed.clear();
+
+    // Clear every cell left without a neighbour one step closer, then the
+    // cells that counted from it in turn
+    while (!check.empty()) {
+        int cur = check.back();
+        check.pop_back();
+        int d = dist[cur];
+        if (d == BLOCKED || d == FAR || d == 0) continue;
+
+        bool supported = false;
+        for (int i = 0; i < 4 && !supported; i++)
+            supported = dist[cur + offsets[i]] == d - 1;
+        if (supported) continue;
+
+        dist[cur] = FAR;
+        reseed.push_back(cur);
+        for (int i = 0; i < 4; i++)
+            if (dist[cur + offsets[i]] == d + 1)
+                check.push_back(cur + offsets[i]);
+    }
+
+    // Fill the cleared and freed cells back in from their edge; the same
+    // wave lowers any cell a freed one opens a shorter way for
+    using Entry = std::pair<int, int>;      // distance, cell
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    for (int cur : reseed) {
+        if (dist[cur] != FAR) continue;
+        int best = FAR;
+        for (int i = 0; i < 4; i++) {
+            int d = dist[cur + offsets[i]];
+            if (d != BLOCKED && d != FAR) best = std::min(best, d + 1);
+        }
+        if (best != FAR) open.push({best, cur});
+    }
+
+    while (!open.empty()) {
+        auto [d, cur] = open.top();
+        open.pop();
+        if (d >= dist[cur]) continue;
+        dist[cur] = d;
+        for (int i = 0; i < 4; i++) {
+            int next = cur + offsets[i];
+            if (dist[next] != BLOCKED && dist[next] > d + 1)
+                open.push({d + 1, next});
+        }
+    }
+    if (metrics) metrics->add(Counter::FIELD_REPAIRS);
+}
+
+int FlowField::distance(int idx) {
+    repair();
+    if (idx == goal) return 0;
+
+    int d = dist[idx];
+    if (d == BLOCKED) {
+        d = FAR;
+        for (int i = 0; i < 4; i++) {
+            int n = dist[idx + grid.neighborOffsets()[i]];
+            if (n != BLOCKED && n != FAR) d = std::min(d, n + 1);
+        }
+    }
+    return d == FAR ? -1 : d;
+}
+
+int FlowField::nextStep(int idx) {
+    repair();
+    int d = dist[idx];
+    if (d == BLOCKED || d == FAR || d == 0) return -1;
+    for (int i = 0; i < 4; i++) {
+        int next = idx + grid.neighborOffsets()[i];
+        if (dist[next] == d - 1)
+            return next;
+    }
+    return -1;
+}
+
+FlowFieldCache::FlowFieldCache(Grid& grid, Metrics* metrics, size_t capacity)
+    : grid(grid), metrics(metrics), capacity(std::max<size_t>(1, capacity)) {}
+
+FlowField& FlowFieldCache::toward(int target) {
+    auto it = std::find_if(fields.begin(), fields.end(),
+                           [target](const std::unique_ptr<FlowField>& f) { return f->target() == target; });
+    if (it != fields.end()) {
+        std::rotate(it, it + 1, fields.end());
+        return *fields.back();
+    }
+
+    if (fields.size() == capacity)
+        fields.erase(fields.begin());
+    fields.push_back(std::make_unique<FlowField>(grid, target, metrics));
+    return *fields.back();
+}
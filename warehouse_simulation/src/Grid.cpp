@@ -1,78 +1,125 @@
 #include "Grid.hpp"
 #include "Robot.hpp"
 
-Grid::Grid(int rows, int cols)
-: rows(rows), cols(cols), cells(rows, std::vector<Cell>(cols)) {}
+#include <algorithm>
+#include <atomic>
 
-void Grid::addRobot(Robot* robot) {
-    robots.push_back(robot);
-}
+namespace {
 
-void Grid::placeBox(int x, int y, int stackSize) {
-    cells[y][x].box = new Box(x, y, stackSize);
+uint64_t nextWallRevision() {
+    static std::atomic<uint64_t> next{1};
+    return next.fetch_add(1, std::memory_order_relaxed);
 }
 
-void Grid::removeBox(int x, int y) {
-    if (cells[y][x].box) {
-        delete cells[y][x].box;
-        cells[y][x].box = nullptr;
+} // namespace
+
+Grid::Grid(int rows, int cols)
+: rows(rows), cols(cols), stride(cols + 2),
+  offsets{1, -1, cols + 2, -(cols + 2)}, boxTiles(store, rows, cols)
+{
+    int count = cellCount();
+    wallBits.resize((count + 63) / 64);
+    boxBits.resize((count + 63) / 64);
+    heights.resize(count);
+    boxes.resize(count);
+    wallRev = nextWallRevision();
+
+    // Wall off the padding border
+    for (int px = 0; px < stride; px++) {
+        setBit(wallBits, px, true);
+        setBit(wallBits, (rows + 1) * stride + px, true);
     }
-    cells[y][x].type = EMPTY;
+    for (int py = 1; py <= rows; py++) {
+        setBit(wallBits, py * stride, true);
+        setBit(wallBits, py * stride + stride - 1, true);
+    }
+}
+
+bool Grid::loadWalls(const uint64_t* words, size_t count) {
+    if (count != wallBits.size()) return false;
+
+    // The border is what lets the searches skip bounds checks, so a mask
+    // without it is rejected rather than trusted
+    auto wall = [words](int idx) { return (words[idx >> 6] >> (idx & 63)) & 1; };
+    for (int px = 0; px < stride; px++)
+        if (!wall(px) || !wall((rows + 1) * stride + px))
+            return false;
+    for (int py = 1; py <= rows; py++)
+        if (!wall(py * stride) || !wall(py * stride + stride - 1))
+            return false;
+
+    std::copy(words, words + count, wallBits.begin());
+    wallRev = nextWallRevision();
+    return true;
 }
 
-bool Grid::hasBox(int x, int y) const {
-    return cells[y][x].box != nullptr;
+long long Grid::wallCount() const {
+    long long walls = 0;
+    for (uint64_t word : wallBits)
+        walls += __builtin_popcountll(word);
+    return walls - (2LL * stride + 2LL * rows);
+}
+
+void Grid::addRobot(Robot* robot) {
+    robots.push_back(robot);
 }
 
-void Grid::draw(sf::RenderWindow& window, int cellSize) {
-    sf::RectangleShape cellRect(sf::Vector2f(cellSize - 1, cellSize - 1));
+void Grid::addObserver(GridObserver* observer) {
+    observers.push_back(observer);
+}
 
-    for (int row = 0; row < rows; row++) {
-        for (int col = 0; col < cols; col++) {
+void Grid::removeObserver(GridObserver* observer) {
+    observers.erase(std::remove(observers.begin(), observers.end(), observer), observers.end());
+}
 
-            cellRect.setPosition(col * cellSize, row * cellSize);
+void Grid::notify(int idx) {
+    for (GridObserver* o : observers)
+        o->onCellChanged(idx);
+}
 
-            switch (cells[row][col].type) {
-                case EMPTY:
-                    cellRect.setFillColor(sf::Color(40, 40, 40));
-                    break;
+void Grid::setBox(int idx, BoxHandle box) {
+    if (boxes[idx]) boxTiles.remove(boxes[idx]);
+    if (box) boxTiles.insert(box);
+    boxes[idx] = box;
+    setBit(boxBits, idx, static_cast<bool>(box));
+    heights[idx] = box ? static_cast<uint8_t>(store.get(box)->stackSize) : 0;
+    notify(idx);
+}
 
-                case WALL:
-                    cellRect.setFillColor(sf::Color(100, 100, 100));
-                    break;
-            }
+void Grid::setWall(int idx, bool wall) {
+    if (isWall(idx) == wall) return;
+    setBit(wallBits, idx, wall);
+    wallRev = nextWallRevision();
+    notify(idx);
+}
 
-            window.draw(cellRect);
+void Grid::placeBox(int x, int y, int stackSize) {
+    setBox(index(x, y), store.create(x, y, stackSize));
+}
 
-            // Draw box if present
-            if (cells[row][col].box)
-                cells[row][col].box->draw(window, cellSize);
-        }
+void Grid::removeBox(int x, int y) {
+    int idx = index(x, y);
+    if (BoxHandle box = boxes[idx]) {
+        setBox(idx, BoxHandle());
+        store.destroy(box);
     }
+    setWall(idx, false);
+}
 
-    // Draw robot
-    for (Robot* r : robots) {
-        int x = r->x;   // horizontal
-        int y = r->y;   // vertical
-
-        sf::RectangleShape rect(sf::Vector2f(cellSize - 2, cellSize - 2));
-        rect.setPosition(x * cellSize, y * cellSize);  // correct
-
-        rect.setFillColor(r->carrying ? sf::Color::Cyan : sf::Color::Yellow);
-        rect.setOutlineThickness(1);
-        rect.setOutlineColor(sf::Color::Black);
-        window.draw(rect);
-
-        if (r->carrying) {
-            sf::CircleShape symbol(5);
-            symbol.setFillColor(sf::Color::White);
-            symbol.setPosition(
-                x * cellSize + cellSize * 0.35,
-                y * cellSize + cellSize * 0.35
-            );
-            window.draw(symbol);
-        }
-    }
+BoxHandle Grid::takeBox(int x, int y) {
+    int idx = index(x, y);
+    BoxHandle box = boxes[idx];
+    setBox(idx, BoxHandle());
+    return box;
+}
+
+void Grid::stackBox(int x, int y, BoxHandle carried) {
+    int idx = index(x, y);
+    Box* target = store.get(boxes[idx]);
+    target->merge(*store.get(carried));
+    heights[idx] = static_cast<uint8_t>(target->stackSize);
+    store.destroy(carried);
+    notify(idx);
 }
 
 const std::vector<Robot*>& Grid::getRobots() const {
@@ -87,11 +134,12 @@ void Grid::addWallRange(int startX, int startY, int endX, int endY) {
 
     for (int y = startY; y <= endY; y++) {
         for (int x = startX; x <= endX; x++) {
-            cells[y][x].type = WALL;
+            int idx = index(x, y);
+            setWall(idx, true);
 
-            if (cells[y][x].box) {
-                delete cells[y][x].box;
-                cells[y][x].box = nullptr;
+            if (BoxHandle box = boxes[idx]) {
+                setBox(idx, BoxHandle());
+                store.destroy(box);
             }
         }
     }
@@ -0,0 +1,175 @@
+#include "GridRenderer.hpp"
+
+namespace {
+
+constexpr size_t QUAD = 6;              // two triangles
+constexpr size_t BOX_VERTICES = 3 * QUAD;       // outline, fill, digit
+constexpr size_t ROBOT_VERTICES = 3 * QUAD;     // outline, fill, carried marker
+
+// Atlas layout: a white block for solid quads, the digits 0-9 as 3x5
+// bitmaps, then a disc
+const sf::FloatRect WHITE(1, 1, 2, 2);
+constexpr int DIGIT_X = 4, DIGIT_W = 3, DIGIT_H = 5;
+constexpr int DISC_X = 48, DISC_SIZE = 16;
+const sf::FloatRect NONE(0, 0, 0, 0);
+
+// One row per line, most significant bit leftmost
+const unsigned char DIGITS[10][DIGIT_H] = {
+    {7, 5, 5, 5, 7}, {2, 6, 2, 2, 7}, {7, 1, 7, 4, 7}, {7, 1, 7, 1, 7}, {5, 5, 7, 1, 1},
+    {7, 4, 7, 1, 7}, {7, 4, 7, 5, 7}, {7, 1, 1, 1, 1}, {7, 5, 7, 5, 7}, {7, 5, 7, 1, 7},
+};
+
+sf::FloatRect digitRect(int digit) {
+    return sf::FloatRect(static_cast<float>(DIGIT_X + digit * (DIGIT_W + 1)), 0, DIGIT_W, DIGIT_H);
+}
+
+const sf::Color FLOOR_COLOR(40, 40, 40);
+const sf::Color WALL_COLOR(100, 100, 100);
+const sf::Color BOX_COLOR(160, 90, 40);     // wood-like
+const sf::Color PIVOT_COLOR(255, 180, 0);   // gold
+
+} // namespace
+
+GridRenderer::GridRenderer(const Grid& grid, int cellSize)
+    : stride(grid.rowStride()), cellSize(cellSize),
+      glyphScale(cellSize >= 8 ? cellSize * 3 / 5 / DIGIT_H : 0),
+      floor(sf::Triangles), boxes(sf::Triangles), robots(sf::Triangles) {
+    buildAtlas();
+    buildFloor(grid);
+}
+
+void GridRenderer::buildAtlas() {
+    sf::Image image;
+    image.create(DISC_X + DISC_SIZE, DISC_SIZE, sf::Color::Transparent);
+
+    for (unsigned y = 0; y < 4; y++)
+        for (unsigned x = 0; x < 4; x++)
+            image.setPixel(x, y, sf::Color::White);
+
+    for (int d = 0; d < 10; d++)
+        for (int y = 0; y < DIGIT_H; y++)
+            for (int x = 0; x < DIGIT_W; x++)
+                if (DIGITS[d][y] & (4 >> x))
+                    image.setPixel(DIGIT_X + d * (DIGIT_W + 1) + x, y, sf::Color::White);
+
+    float r = DISC_SIZE / 2.0f;
+    for (int y = 0; y < DISC_SIZE; y++)
+        for (int x = 0; x < DISC_SIZE; x++) {
+            float dx = x + 0.5f - r, dy = y + 0.5f - r;
+            if (dx * dx + dy * dy <= r * r)
+                image.setPixel(DISC_X + x, y, sf::Color::White);
+        }
+
+    // Nearest sampling keeps the digits crisp at any cell size
+    atlas.loadFromImage(image);
+    atlas.setSmooth(false);
+}
+
+void GridRenderer::setQuad(sf::Vertex* at, float x, float y, float w, float h, sf::Color color, sf::FloatRect tex) {
+    sf::Vector2f corners[4] = {{x, y}, {x + w, y}, {x + w, y + h}, {x, y + h}};
+    sf::Vector2f texels[4] = {{tex.left, tex.top},
+                              {tex.left + tex.width, tex.top},
+                              {tex.left + tex.width, tex.top + tex.height},
+                              {tex.left, tex.top + tex.height}};
+    const int order[QUAD] = {0, 1, 2, 0, 2, 3};
+    for (size_t i = 0; i < QUAD; i++)
+        at[i] = sf::Vertex(corners[order[i]], color, texels[order[i]]);
+}
+
+void GridRenderer::buildFloor(const Grid& grid) {
+    floor.resize(static_cast<size_t>(grid.rows) * grid.cols * QUAD);
+    for (int y = 0; y < grid.rows; y++)
+        for (int x = 0; x < grid.cols; x++)
+            setQuad(&floor[(static_cast<size_t>(y) * grid.cols + x) * QUAD], static_cast<float>(x * cellSize),
+                    static_cast<float>(y * cellSize), cellSize - 1.0f, cellSize - 1.0f,
+                    grid.isWall(x, y) ? WALL_COLOR : FLOOR_COLOR, WHITE);
+}
+
+void GridRenderer::syncBoxes(const Snapshot& snapshot) {
+    if (snapshot.boxVersion == drawnVersion) return;
+
+    // Both lists are in cell order: one merge pass finds what changed
+    const std::vector<SnapshotBox>& next = snapshot.boxes;
+    size_t i = 0, j = 0;
+    while (i < drawnBoxes.size() || j < next.size()) {
+        if (j == next.size() || (i < drawnBoxes.size() && drawnBoxes[i].cell < next[j].cell)) {
+            removeBox(drawnBoxes[i++].cell);
+        } else if (i == drawnBoxes.size() || next[j].cell < drawnBoxes[i].cell) {
+            slotOfCell[next[j].cell] = cellOfSlot.size();
+            cellOfSlot.push_back(next[j].cell);
+            boxes.resize(cellOfSlot.size() * BOX_VERTICES);
+            writeBox(cellOfSlot.size() - 1, next[j++]);
+        } else {
+            if (drawnBoxes[i].height != next[j].height || drawnBoxes[i].pivot != next[j].pivot)
+                writeBox(slotOfCell[next[j].cell], next[j]);
+            i++;
+            j++;
+        }
+    }
+    drawnBoxes = next;
+    drawnVersion = snapshot.boxVersion;
+}
+
+void GridRenderer::writeBox(size_t slot, const SnapshotBox& box) {
+    float left = static_cast<float>((box.cell % stride - 1) * cellSize);
+    float top = static_cast<float>((box.cell / stride - 1) * cellSize);
+    float size = static_cast<float>(cellSize);
+    sf::Vertex* at = &boxes[slot * BOX_VERTICES];
+
+    setQuad(at, left, top, size, size, sf::Color::Black, WHITE);
+    setQuad(at + QUAD, left + 2, top + 2, size - 4, size - 4, box.pivot ? PIVOT_COLOR : BOX_COLOR, WHITE);
+
+    if (glyphScale > 0) {
+        float w = static_cast<float>(DIGIT_W * glyphScale), h = static_cast<float>(DIGIT_H * glyphScale);
+        setQuad(at + 2 * QUAD, left + (size - w) / 2, top + (size - h) / 2, w, h, sf::Color::White,
+                digitRect(box.height % 10));
+    } else {
+        setQuad(at + 2 * QUAD, left, top, 0, 0, sf::Color::Transparent, NONE);
+    }
+}
+
+void GridRenderer::removeBox(int cell) {
+    auto it = slotOfCell.find(cell);
+    if (it == slotOfCell.end()) return;
+
+    size_t slot = it->second, last = cellOfSlot.size() - 1;
+    slotOfCell.erase(it);
+    if (slot != last) {
+        for (size_t i = 0; i < BOX_VERTICES; i++)
+            boxes[slot * BOX_VERTICES + i] = boxes[last * BOX_VERTICES + i];
+        cellOfSlot[slot] = cellOfSlot[last];
+        slotOfCell[cellOfSlot[slot]] = slot;
+    }
+    cellOfSlot.pop_back();
+    boxes.resize(cellOfSlot.size() * BOX_VERTICES);
+}
+
+void GridRenderer::fillRobots(const Snapshot& snapshot, float alpha) {
+    robots.resize(snapshot.robots.size() * ROBOT_VERTICES);
+
+    float size = static_cast<float>(cellSize);
+    for (size_t i = 0; i < snapshot.robots.size(); i++) {
+        const SnapshotRobot& r = snapshot.robots[i];
+        float left = (r.fromX + (r.x - r.fromX) * alpha) * size;
+        float top = (r.fromY + (r.y - r.fromY) * alpha) * size;
+        sf::Vertex* at = &robots[i * ROBOT_VERTICES];
+
+        setQuad(at, left - 1, top - 1, size, size, sf::Color::Black, WHITE);
+        setQuad(at + QUAD, left, top, size - 2, size - 2, r.carrying ? sf::Color::Cyan : sf::Color::Yellow, WHITE);
+        if (r.carrying)
+            setQuad(at + 2 * QUAD, left + size * 0.35f, top + size * 0.35f, size * 0.5f, size * 0.5f, sf::Color::White,
+                    sf::FloatRect(DISC_X, 0, DISC_SIZE, DISC_SIZE));
+        else
+            setQuad(at + 2 * QUAD, left, top, 0, 0, sf::Color::Transparent, NONE);
+    }
+}
+
+void GridRenderer::draw(sf::RenderTarget& target, const Snapshot& snapshot, float alpha) {
+    syncBoxes(snapshot);
+    fillRobots(snapshot, alpha);
+
+    sf::RenderStates states(&atlas);
+    target.draw(floor, states);
+    target.draw(boxes, states);
+    target.draw(robots, states);
+}
@@ -0,0 +1,442 @@
+#include "HierarchicalPlanner.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+
+namespace {
+
+// Transitions per stretch of open border: one in the middle of a short one,
+// one at each end of a long one
+constexpr int LONG_ENTRANCE = 6;
+
+// A hop blocked by boxes is merged with up to this many following ones
+constexpr size_t MAX_MERGED_HOPS = 3;
+
+// Identifies one build of one cluster, process-wide
+std::atomic<uint64_t> nextStamp{1};
+
+inline int manhattan(const Grid& grid, int a, int b) {
+    int stride = grid.rowStride();
+    return std::abs(a % stride - b % stride) + std::abs(a / stride - b / stride);
+}
+
+} // namespace
+
+HierarchicalPlanner::HierarchicalPlanner(int clusterSize)
+    : clusterSize(std::min(62, std::max(4, clusterSize))), sideSlots(this->clusterSize / 2 + 1),
+      direct(makePlanner(PlannerKind::ASTAR)) {}
+
+int HierarchicalPlanner::nodeId(int cluster, int node) const {
+    const Cluster& c = clusters[cluster];
+    int side = 0;
+    while (node >= c.first[side + 1]) side++;
+    return nodeId(cluster, side, node - c.first[side]);
+}
+
+int HierarchicalPlanner::clusterOf(const Grid& grid, int idx) const {
+    int across = (grid.cols + clusterSize - 1) / clusterSize;
+    return grid.yOf(idx) / clusterSize * across + grid.xOf(idx) / clusterSize;
+}
+
+HierarchicalPlanner::Rect HierarchicalPlanner::bounds(int cluster) const {
+    int x0 = cluster % clustersX * clusterSize;
+    int y0 = cluster / clustersX * clusterSize;
+    return {x0, y0, std::min(cols, x0 + clusterSize), std::min(rows, y0 + clusterSize)};
+}
+
+int HierarchicalPlanner::neighbour(int cluster, int side) const {
+    int cx = cluster % clustersX, cy = cluster / clustersX;
+    switch (side) {
+        case NORTH: return cy > 0 ? cluster - clustersX : -1;
+        case SOUTH: return cy + 1 < clustersY ? cluster + clustersX : -1;
+        case WEST: return cx > 0 ? cluster - 1 : -1;
+        case EAST: return cx + 1 < clustersX ? cluster + 1 : -1;
+    }
+    return -1;
+}
+
+size_t HierarchicalPlanner::nodeCount(const Grid& grid) const {
+    ensureBuilt(grid);
+    size_t count = 0;
+    for (const Cluster& c : clusters)
+        count += c.cells.size();
+    return count;
+}
+
+// ---- building -------------------------------------------------------------
+
+void HierarchicalPlanner::ensureBuilt(const Grid& grid) const {
+    // Revisions are unique across grids, so an equal one means the same walls
+    if (builtRevision.load(std::memory_order_acquire) == grid.wallRevision())
+        return;
+
+    std::lock_guard<std::mutex> lock(buildMutex);
+    uint64_t built = builtRevision.load(std::memory_order_relaxed);
+    if (built == grid.wallRevision())
+        return;
+    if (built != 0 && rows == grid.rows && cols == grid.cols) {
+        rebuildChanged(grid);
+    } else {
+        rows = grid.rows;
+        cols = grid.cols;
+        clustersX = (cols + clusterSize - 1) / clusterSize;
+        clustersY = (rows + clusterSize - 1) / clusterSize;
+        clusters.assign(static_cast<size_t>(clustersX) * clustersY, Cluster());
+        ready.reset(new std::atomic<bool>[clusters.size()]);
+        for (int c = 0; c < static_cast<int>(clusters.size()); c++)
+            buildCluster(grid, c);
+        builtWalls.assign(grid.wallMask().begin(), grid.wallMask().end());
+    }
+
+    builtRevision.store(grid.wallRevision(), std::memory_order_release);
+}
+
+void HierarchicalPlanner::rebuildChanged(const Grid& grid) const {
+    const CellArray<uint64_t>& walls = grid.wallMask();
+    std::vector<char> dirty(clusters.size(), 0);
+
+    for (size_t w = 0; w < walls.size(); w++) {
+        for (uint64_t diff = walls[w] ^ builtWalls[w]; diff; diff &= diff - 1) {
+            int idx = static_cast<int>(w * 64) + __builtin_ctzll(diff);
+            int x = grid.xOf(idx), y = grid.yOf(idx);
+            if (!grid.inBounds(x, y)) continue;
+
+            // A cell on a border also moves the neighbour's transitions
+            int c = clusterOf(grid, idx);
+            Rect r = bounds(c);
+            dirty[c] = 1;
+            if (y == r.y0 && neighbour(c, NORTH) >= 0) dirty[neighbour(c, NORTH)] = 1;
+            if (y == r.y1 - 1 && neighbour(c, SOUTH) >= 0) dirty[neighbour(c, SOUTH)] = 1;
+            if (x == r.x0 && neighbour(c, WEST) >= 0) dirty[neighbour(c, WEST)] = 1;
+            if (x == r.x1 - 1 && neighbour(c, EAST) >= 0) dirty[neighbour(c, EAST)] = 1;
+        }
+    }
+
+    for (int c = 0; c < static_cast<int>(clusters.size()); c++)
+        if (dirty[c]) buildCluster(grid, c);
+    std::copy(walls.begin(), walls.end(), builtWalls.begin());
+}
+
+void HierarchicalPlanner::findTransitions(const Grid& grid, int cluster, int side, std::vector<int>& cells) const {
+    if (neighbour(cluster, side) < 0) return;
+
+    // Walk the border in increasing coordinate order, from either cluster's
+    // side the same, so transition k means the same crossing to both
+    Rect r = bounds(cluster);
+    int stride = grid.rowStride();
+    int first, step, length, across;
+    switch (side) {
+        case NORTH: first = grid.index(r.x0, r.y0); step = 1; length = r.x1 - r.x0; across = -stride; break;
+        case SOUTH: first = grid.index(r.x0, r.y1 - 1); step = 1; length = r.x1 - r.x0; across = stride; break;
+        case WEST: first = grid.index(r.x0, r.y0); step = stride; length = r.y1 - r.y0; across = -1; break;
+        default: first = grid.index(r.x1 - 1, r.y0); step = stride; length = r.y1 - r.y0; across = 1; break;
+    }
+
+    int run = 0;
+    for (int i = 0; i <= length; i++) {
+        int idx = first + i * step;
+        if (i < length && !grid.isWall(idx) && !grid.isWall(idx + across)) {
+            run++;
+            continue;
+        }
+        if (run > 0) {
+            int runStart = i - run;
+            if (run < LONG_ENTRANCE) {
+                cells.push_back(first + (runStart + run / 2) * step);
+            } else {
+                cells.push_back(first + runStart * step);
+                cells.push_back(first + (i - 1) * step);
+            }
+        }
+        run = 0;
+    }
+}
+
+void HierarchicalPlanner::buildCluster(const Grid& grid, int cluster) const {
+    Cluster& c = clusters[cluster];
+    c.cells.clear();
+    for (int side = 0; side < 4; side++) {
+        c.first[side] = static_cast<uint16_t>(c.cells.size());
+        findTransitions(grid, cluster, side, c.cells);
+    }
+    c.first[4] = static_cast<uint16_t>(c.cells.size());
+    ready[cluster].store(false, std::memory_order_relaxed);
+}
+
+void HierarchicalPlanner::ensureDistances(const Grid& grid, int cluster) const {
+    if (ready[cluster].load(std::memory_order_acquire)) return;
+
+    std::lock_guard<std::mutex> lock(distanceMutex);
+    if (ready[cluster].load(std::memory_order_relaxed)) return;
+
+    Cluster& c = clusters[cluster];
+    Rect r = bounds(cluster);
+    c.open = true;
+    for (int y = r.y0; y < r.y1 && c.open; y++)
+        for (int x = r.x0; x < r.x1; x++)
+            if (grid.isWall(x, y)) {
+                c.open = false;
+                break;
+            }
+
+    // Distances are symmetric: each search only needs the nodes after its own
+    c.stamp = nextStamp.fetch_add(1, std::memory_order_relaxed);
+    size_t n = c.cells.size();
+    c.dist.resize(n * n);
+    std::vector<uint16_t> row;
+    for (size_t i = 0; i < n; i++) {
+        distancesFrom(grid, cluster, c.cells[i], row, i);
+        for (size_t j = i; j < n; j++)
+            c.dist[i * n + j] = c.dist[j * n + i] = row[j];
+    }
+    ready[cluster].store(true, std::memory_order_release);
+}
+
+void HierarchicalPlanner::distancesFrom(const Grid& grid, int cluster, int idx, std::vector<uint16_t>& out,
+                                        size_t needFrom) const {
+    const Cluster& c = clusters[cluster];
+    out.assign(c.cells.size(), UNREACHABLE);
+
+    if (c.open) {
+        for (size_t i = needFrom; i < c.cells.size(); i++)
+            out[i] = static_cast<uint16_t>(manhattan(grid, idx, c.cells[i]));
+        return;
+    }
+
+    // Breadth-first one wave at a time over the cluster's rows as bitmasks
+    // (a cluster is at most 62 wide, so a row fits a word with room to
+    // shift). The rows are kept while the same build of a cluster is asked
+    // again, as it is once per node while the cluster is built.
+    struct Local {
+        uint64_t stamp = 0;
+        std::vector<uint64_t> open;         // bit x of row y: cell (x0 + x, y0 + y) is not a wall
+        std::vector<int> nodeX, nodeY;
+        std::vector<uint64_t> visited, frontier, next;
+    };
+    thread_local Local local;
+
+    Rect r = bounds(cluster);
+    int height = r.y1 - r.y0;
+    if (local.stamp != c.stamp) {
+        local.stamp = c.stamp;
+        local.open.assign(height, 0);
+        for (int y = 0; y < height; y++)
+            for (int x = 0; x < r.x1 - r.x0; x++)
+                if (!grid.isWall(r.x0 + x, r.y0 + y))
+                    local.open[y] |= uint64_t(1) << x;
+        local.nodeX.clear();
+        local.nodeY.clear();
+        for (int cell : c.cells) {
+            local.nodeX.push_back(grid.xOf(cell) - r.x0);
+            local.nodeY.push_back(grid.yOf(cell) - r.y0);
+        }
+    }
+
+    local.visited.assign(height, 0);
+    local.frontier.assign(height, 0);
+    local.next.assign(height, 0);
+
+    int sy = grid.yOf(idx) - r.y0;
+    local.frontier[sy] = local.visited[sy] = uint64_t(1) << (grid.xOf(idx) - r.x0);
+    int lo = sy, hi = sy;       // rows the frontier spans
+
+    size_t left = c.cells.size() - std::min(needFrom, c.cells.size());
+    for (uint16_t d = 0; ; d++) {
+        for (size_t i = needFrom; i < out.size(); i++)
+            if (out[i] == UNREACHABLE && ((local.frontier[local.nodeY[i]] >> local.nodeX[i]) & 1)) {
+                out[i] = d;
+                left--;
+            }
+        if (left == 0) break;
+
+        int nextLo = height, nextHi = -1;
+        for (int y = std::max(0, lo - 1); y <= std::min(height - 1, hi + 1); y++) {
+            uint64_t f = local.frontier[y];
+            uint64_t reach = (f << 1) | (f >> 1) | (y > 0 ? local.frontier[y - 1] : 0) |
+                             (y + 1 < height ? local.frontier[y + 1] : 0);
+            local.next[y] = reach & local.open[y] & ~local.visited[y];
+            if (local.next[y]) {
+                nextLo = std::min(nextLo, y);
+                nextHi = std::max(nextHi, y);
+            }
+        }
+        if (nextHi < 0) break;
+
+        for (int y = lo; y <= hi; y++)
+            local.frontier[y] = 0;
+        std::swap(local.frontier, local.next);
+        for (int y = nextLo; y <= nextHi; y++)
+            local.visited[y] |= local.frontier[y];
+        lo = nextLo;
+        hi = nextHi;
+    }
+}
+
+// ---- queries --------------------------------------------------------------
+
+bool HierarchicalPlanner::searchAbstract(const Grid& grid, int start, int goal, std::vector<int>& waypoints,
+                                         int& expanded) const {
+    int startCluster = clusterOf(grid, start), goalCluster = clusterOf(grid, goal);
+    ensureDistances(grid, startCluster);
+    ensureDistances(grid, goalCluster);
+    thread_local std::vector<uint16_t> fromStart, toGoal;
+    distancesFrom(grid, startCluster, start, fromStart);
+    distancesFrom(grid, goalCluster, goal, toGoal);
+
+    // Start and goal join the graph for this query only, as two extra ids
+    const int startId = idCount(), goalId = startId + 1;
+    auto cellOf = [&](int id) {
+        if (id == startId) return start;
+        if (id == goalId) return goal;
+        const Cluster& c = clusters[id / (4 * sideSlots)];
+        return c.cells[c.first[id / sideSlots % 4] + id % sideSlots];
+    };
+
+    SearchWorkspace& ws = SearchWorkspace::local();
+    ws.begin(goalId + 1);
+    ws.open(startId, 0, manhattan(grid, start, goal), startId);
+
+    auto relax = [&](int from, int g, int to, int cost) {
+        int ng = g + cost;
+        if (!ws.seen(to) || ng < ws.g(to))
+            ws.open(to, ng, ng + manhattan(grid, cellOf(to), goal), from);
+    };
+
+    bool found = false;
+    while (!ws.empty()) {
+        SearchWorkspace::OpenEntry e = ws.pop();
+        if (ws.closed(e.idx) || e.g > ws.g(e.idx)) continue;
+        ws.close(e.idx);
+        expanded++;
+
+        if (e.idx == goalId) {
+            found = true;
+            break;
+        }
+
+        if (e.idx == startId) {
+            for (size_t j = 0; j < fromStart.size(); j++)
+                if (fromStart[j] != UNREACHABLE)
+                    relax(e.idx, e.g, nodeId(startCluster, static_cast<int>(j)), fromStart[j]);
+            continue;
+        }
+
+        int cluster = e.idx / (4 * sideSlots), side = e.idx / sideSlots % 4, k = e.idx % sideSlots;
+        ensureDistances(grid, cluster);
+        const Cluster& c = clusters[cluster];
+        size_t n = c.cells.size(), node = c.first[side] + k;
+
+        for (size_t j = 0; j < n; j++) {
+            uint16_t d = c.dist[node * n + j];
+            if (j != node && d != UNREACHABLE)
+                relax(e.idx, e.g, nodeId(cluster, static_cast<int>(j)), d);
+        }
+
+        // Across the border: the opposite side of the neighbour, same k
+        relax(e.idx, e.g, nodeId(neighbour(cluster, side), side ^ 1, k), 1);
+
+        if (cluster == goalCluster && toGoal[node] != UNREACHABLE)
+            relax(e.idx, e.g, goalId, toGoal[node]);
+    }
+    if (!found) return false;
+
+    waypoints.clear();
+    for (int id = goalId; ; id = ws.parentOf(id)) {
+        int cell = cellOf(id);
+        if (waypoints.empty() || waypoints.back() != cell)
+            waypoints.push_back(cell);
+        if (id == startId) break;
+    }
+    std::reverse(waypoints.begin(), waypoints.end());
+    return true;
+}
+
+bool HierarchicalPlanner::searchWithin(const Grid& grid, int from, int to, Rect area, std::vector<Pos>& path,
+                                       int& expanded) const {
+    SearchWorkspace& ws = SearchWorkspace::local();
+    ws.begin(grid.cellCount());
+    ws.open(from, 0, manhattan(grid, from, to), from);
+
+    const int* offsets = grid.neighborOffsets();
+    bool found = false;
+    while (!ws.empty()) {
+        SearchWorkspace::OpenEntry e = ws.pop();
+        if (ws.closed(e.idx) || e.g > ws.g(e.idx)) continue;
+        ws.close(e.idx);
+        expanded++;
+
+        if (e.idx == to) {
+            found = true;
+            break;
+        }
+
+        for (int i = 0; i < 4; i++) {
+            int next = e.idx + offsets[i];
+            if (grid.isWall(next) || (grid.hasBox(next) && next != to)) continue;
+            int x = grid.xOf(next), y = grid.yOf(next);
+            if (x < area.x0 || x >= area.x1 || y < area.y0 || y >= area.y1) continue;
+
+            int ng = e.g + 1;
+            if (!ws.seen(next) || ng < ws.g(next))
+                ws.open(next, ng, ng + manhattan(grid, next, to), e.idx);
+        }
+    }
+    if (!found) return false;
+
+    size_t mark = path.size();
+    for (int cur = to; cur != from; cur = ws.parentOf(cur))
+        path.push_back({grid.xOf(cur), grid.yOf(cur)});
+    std::reverse(path.begin() + mark, path.end());
+    return true;
+}
+
+bool HierarchicalPlanner::findPath(const Grid& grid, Pos startPos, Pos goalPos,
+                                   std::vector<Pos>& path, SearchStats* stats) const {
+    path.clear();
+    if (!grid.inBounds(startPos.first, startPos.second) || !grid.inBounds(goalPos.first, goalPos.second))
+        return false;
+
+    int start = grid.index(startPos.first, startPos.second);
+    int goal = grid.index(goalPos.first, goalPos.second);
+    if (grid.isWall(goal) || start == goal) return false;
+    if (clusterOf(grid, start) == clusterOf(grid, goal))
+        return direct->findPath(grid, startPos, goalPos, path, stats);
+
+    ensureBuilt(grid);
+
+    int expanded = 0;
+    thread_local std::vector<int> waypoints;
+    if (!searchAbstract(grid, start, goal, waypoints, expanded)) {
+        // The graph keeps every connection the walls allow, so this is final
+        if (stats) stats->expanded += expanded;
+        return false;
+    }
+
+    // Refine hop by hop; a hop into a box or walled off by boxes is merged
+    // with the next ones, which widens the area searched around it
+    size_t at = 0;
+    while (at + 1 < waypoints.size()) {
+        size_t reached = 0;
+        for (size_t next = at + 1; next < waypoints.size() && next <= at + MAX_MERGED_HOPS; next++) {
+            int to = waypoints[next];
+            if (to != goal && grid.hasBox(to)) continue;
+
+            Rect a = bounds(clusterOf(grid, waypoints[at])), b = bounds(clusterOf(grid, to));
+            Rect area{std::min(a.x0, b.x0), std::min(a.y0, b.y0), std::max(a.x1, b.x1), std::max(a.y1, b.y1)};
+            if (searchWithin(grid, waypoints[at], to, area, path, expanded)) {
+                reached = next;
+                break;
+            }
+        }
+
+        if (!reached) {
+            if (stats) stats->expanded += expanded;
+            return direct->findPath(grid, startPos, goalPos, path, stats);
+        }
+        at = reached;
+    }
+
+    if (stats) stats->expanded += expanded;
+    return true;
+}
@@ -0,0 +1,296 @@
+#include "Layout.hpp"
+
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char MAGIC[8] = {'W', 'H', 'L', 'A', 'Y', 'O', 'U', 'T'};
+constexpr uint32_t VERSION = 1;
+
+struct BinaryHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t rows, cols;
+    uint32_t reserved;
+    uint64_t wallWords;
+    uint64_t boxCount;
+    uint64_t dockCount;
+};
+
+// The sections follow the header back to back, each naturally aligned
+static_assert(sizeof(BinaryHeader) == 48, "binary layout header is 48 bytes");
+static_assert(sizeof(LayoutBox) == 12 && sizeof(LayoutDock) == 8, "layout records are packed int32s");
+
+constexpr int MAX_HEIGHT = 5;
+
+// Same padded index as Grid::index
+int maskIndex(int cols, int x, int y) {
+    return (y + 1) * (cols + 2) + (x + 1);
+}
+
+void setMaskBit(std::vector<uint64_t>& words, int idx) {
+    words[idx >> 6] |= uint64_t(1) << (idx & 63);
+}
+
+bool validSize(long long rows, long long cols) {
+    return rows >= 1 && cols >= 1 && (rows + 2) * (cols + 2) <= INT_MAX;
+}
+
+bool inBounds(const Layout& layout, long long x, long long y) {
+    return x >= 0 && y >= 0 && x < layout.cols && y < layout.rows;
+}
+
+} // namespace
+
+size_t Layout::maskWords(int rows, int cols) {
+    return (static_cast<size_t>(rows + 2) * (cols + 2) + 63) / 64;
+}
+
+bool Layout::isWall(int x, int y) const {
+    int idx = maskIndex(cols, x, y);
+    return (walls[idx >> 6] >> (idx & 63)) & 1;
+}
+
+bool Layout::parseText(std::istream& in, const std::string& name, std::string& error) {
+    std::string line;
+    int lineNo = 0;
+    int mapRow = -1;        // >= 0 while reading the rows of a map section
+    bool sized = false;
+
+    auto fail = [&](const std::string& what) {
+        error = name + ":" + std::to_string(lineNo) + ": " + what;
+        return false;
+    };
+
+    while (std::getline(in, line)) {
+        lineNo++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+
+        if (mapRow >= 0) {
+            if (static_cast<int>(line.size()) != cols)
+                return fail("map rows must be " + std::to_string(cols) + " cells wide");
+            for (int x = 0; x < cols; x++) {
+                char c = line[x];
+                if (c == '#' || c == 'S') setMaskBit(ownedWalls, maskIndex(cols, x, mapRow));
+                else if (c >= '1' && c <= '0' + MAX_HEIGHT) ownedBoxes.push_back({x, mapRow, c - '0'});
+                else if (c == 'D') ownedDocks.push_back({x, mapRow});
+                else if (c != '.') return fail(std::string("unknown map cell '") + c + "'");
+            }
+            if (++mapRow == rows) mapRow = -1;
+            continue;
+        }
+
+        std::string directive = line.substr(0, line.find('#'));
+        std::istringstream words(directive);
+        std::string keyword;
+        if (!(words >> keyword)) continue;
+
+        long long a = 0, b = 0, c = 0, d = 0;
+        if (keyword == "warehouse-layout") {
+            if (!(words >> a) || a != VERSION) return fail("unsupported layout version");
+        } else if (keyword == "size") {
+            if (sized) return fail("size given twice");
+            if (!(words >> a >> b) || !validSize(b, a)) return fail("size expects COLS ROWS");
+            cols = static_cast<int>(a);
+            rows = static_cast<int>(b);
+            ownedWalls.assign(maskWords(rows, cols), 0);
+
+            // The border, as Grid lays it out
+            int stride = cols + 2;
+            for (int px = 0; px < stride; px++) {
+                setMaskBit(ownedWalls, px);
+                setMaskBit(ownedWalls, (rows + 1) * stride + px);
+            }
+            for (int py = 1; py <= rows; py++) {
+                setMaskBit(ownedWalls, py * stride);
+                setMaskBit(ownedWalls, py * stride + stride - 1);
+            }
+            sized = true;
+        } else if (!sized) {
+            return fail("size must come first");
+        } else if (keyword == "wall" || keyword == "shelf") {
+            if (!(words >> a >> b >> c >> d) || !inBounds(*this, a, b) || !inBounds(*this, c, d) || a > c || b > d)
+                return fail(keyword + " expects X0 Y0 X1 Y1 inside the grid");
+            for (long long y = b; y <= d; y++)
+                for (long long x = a; x <= c; x++)
+                    setMaskBit(ownedWalls, maskIndex(cols, static_cast<int>(x), static_cast<int>(y)));
+        } else if (keyword == "box") {
+            if (!(words >> a >> b) || !inBounds(*this, a, b)) return fail("box expects X Y inside the grid");
+            // The height is optional, but one that is there has to parse
+            c = 1;
+            if (!(words >> std::ws).eof() && (!(words >> c) || c < 1 || c > MAX_HEIGHT))
+                return fail("box height must be 1-5");
+            ownedBoxes.push_back({static_cast<int32_t>(a), static_cast<int32_t>(b), static_cast<int32_t>(c)});
+        } else if (keyword == "dock") {
+            if (!(words >> a >> b) || !inBounds(*this, a, b)) return fail("dock expects X Y inside the grid");
+            ownedDocks.push_back({static_cast<int32_t>(a), static_cast<int32_t>(b)});
+        } else if (keyword == "map") {
+            mapRow = 0;
+        } else {
+            return fail("unknown directive " + keyword);
+        }
+
+        std::string extra;
+        if (words >> extra) return fail("unexpected '" + extra + "' after " + keyword);
+    }
+
+    if (!sized) return fail("no size given");
+    if (mapRow >= 0) return fail("map ends after " + std::to_string(mapRow) + " of " + std::to_string(rows) + " rows");
+
+    walls = ownedWalls.data();
+    wallCount = ownedWalls.size();
+    boxList = ownedBoxes.data();
+    boxTotal = ownedBoxes.size();
+    dockList = ownedDocks.data();
+    dockTotal = ownedDocks.size();
+    return true;
+}
+
+bool Layout::mapBinary(const std::string& path, std::string& error) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot read " + path;
+        return false;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(BinaryHeader)) {
+        ::close(fd);
+        error = path + ": truncated layout";
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(info.st_size);
+    void* base = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        error = "cannot map " + path;
+        return false;
+    }
+    mapping = std::shared_ptr<const void>(base, [size](const void* p) { ::munmap(const_cast<void*>(p), size); });
+
+    BinaryHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+        error = path + ": not a version 1 binary layout";
+        return false;
+    }
+    if (!validSize(header.rows, header.cols) || header.wallWords != maskWords(header.rows, header.cols) ||
+        header.boxCount > size || header.dockCount > size ||
+        size != sizeof(BinaryHeader) + header.wallWords * 8 + header.boxCount * sizeof(LayoutBox) +
+                    header.dockCount * sizeof(LayoutDock)) {
+        error = path + ": corrupt layout header";
+        return false;
+    }
+
+    rows = static_cast<int>(header.rows);
+    cols = static_cast<int>(header.cols);
+    const char* bytes = static_cast<const char*>(base);
+    walls = reinterpret_cast<const uint64_t*>(bytes + sizeof(BinaryHeader));
+    wallCount = header.wallWords;
+    boxList = reinterpret_cast<const LayoutBox*>(walls + wallCount);
+    boxTotal = header.boxCount;
+    dockList = reinterpret_cast<const LayoutDock*>(boxList + boxTotal);
+    dockTotal = header.dockCount;
+
+    // Per record, never per cell
+    for (size_t i = 0; i < boxTotal; i++) {
+        const LayoutBox& b = boxList[i];
+        if (!inBounds(*this, b.x, b.y) || b.height < 1 || b.height > MAX_HEIGHT) {
+            error = path + ": box " + std::to_string(i) + " is out of range";
+            return false;
+        }
+    }
+    for (size_t i = 0; i < dockTotal; i++) {
+        if (!inBounds(*this, dockList[i].x, dockList[i].y)) {
+            error = path + ": dock " + std::to_string(i) + " is outside the grid";
+            return false;
+        }
+    }
+    return true;
+}
+
+std::shared_ptr<const Layout> loadLayout(const std::string& path, std::string& error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "cannot read " + path;
+        return nullptr;
+    }
+    char magic[sizeof(MAGIC)] = {};
+    in.read(magic, sizeof(magic));
+
+    auto layout = std::make_shared<Layout>();
+    if (in.gcount() == sizeof(magic) && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0) {
+        in.close();
+        if (!layout->mapBinary(path, error)) return nullptr;
+    } else {
+        in.clear();
+        in.seekg(0);
+        if (!layout->parseText(in, path, error)) return nullptr;
+    }
+    return layout;
+}
+
+bool saveLayoutBinary(const Layout& layout, const std::string& path, std::string& error) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        error = "cannot write " + path;
+        return false;
+    }
+
+    BinaryHeader header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.rows = static_cast<uint32_t>(layout.rows);
+    header.cols = static_cast<uint32_t>(layout.cols);
+    header.wallWords = layout.wallWordCount();
+    header.boxCount = layout.boxCount();
+    header.dockCount = layout.dockCount();
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(layout.wallWords()), static_cast<std::streamsize>(header.wallWords * 8));
+    out.write(reinterpret_cast<const char*>(layout.boxes()),
+              static_cast<std::streamsize>(header.boxCount * sizeof(LayoutBox)));
+    out.write(reinterpret_cast<const char*>(layout.docks()),
+              static_cast<std::streamsize>(header.dockCount * sizeof(LayoutDock)));
+    if (!out) {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool saveLayoutText(const Layout& layout, const std::string& path, std::string& error) {
+    std::ofstream out(path);
+    if (!out) {
+        error = "cannot write " + path;
+        return false;
+    }
+
+    std::vector<std::string> map(layout.rows, std::string(layout.cols, '.'));
+    for (int y = 0; y < layout.rows; y++)
+        for (int x = 0; x < layout.cols; x++)
+            if (layout.isWall(x, y)) map[y][x] = '#';
+    for (size_t i = 0; i < layout.boxCount(); i++)
+        map[layout.boxes()[i].y][layout.boxes()[i].x] = static_cast<char>('0' + layout.boxes()[i].height);
+    for (size_t i = 0; i < layout.dockCount(); i++)
+        map[layout.docks()[i].y][layout.docks()[i].x] = 'D';
+
+    out << "warehouse-layout " << VERSION << "\n"
+        << "size " << layout.cols << " " << layout.rows << "\n"
+        << "map\n";
+    for (const std::string& row : map)
+        out << row << "\n";
+    if (!out) {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,185 @@
+#include "Log.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <thread>
+
+namespace logging {
+
+// Constant-initialized, so no statement can log before start() runs
+constexpr uint8_t LEVEL_OFF = static_cast<uint8_t>(Level::OFF);
+static_assert(static_cast<int>(Category::COUNT) == 4, "one OFF per category");
+std::atomic<uint8_t> thresholds[static_cast<int>(Category::COUNT)] = {LEVEL_OFF, LEVEL_OFF, LEVEL_OFF, LEVEL_OFF};
+
+namespace {
+
+const char* levelName(Level level) {
+    switch (level) {
+        case Level::TRACE: return "TRACE";
+        case Level::DEBUG: return "DEBUG";
+        case Level::INFO:  return "INFO ";
+        case Level::WARN:  return "WARN ";
+        case Level::ERROR: return "ERROR";
+        case Level::OFF:   break;
+    }
+    return "?";
+}
+
+const char* categoryName(Category category) {
+    switch (category) {
+        case Category::SIM:     return "sim";
+        case Category::ROBOT:   return "robot";
+        case Category::PLANNER: return "planner";
+        case Category::ACL:     return "acl";
+        case Category::COUNT:   break;
+    }
+    return "?";
+}
+
+// Bounded multi-producer queue (Vyukov). Each cell's sequence number says
+// whether it is free for the producer at `pos` (seq == pos) or holds the
+// record the consumer at `pos` expects (seq == pos + 1). Producers claim a
+// position with one CAS; the single consumer needs no atomics of its own.
+class RingBuffer {
+public:
+    static constexpr size_t CAPACITY = size_t(1) << 14;
+
+    RingBuffer() : cells(new Cell[CAPACITY]) { reset(); }
+
+    // Only while no producer or consumer is running
+    void reset() {
+        for (size_t i = 0; i < CAPACITY; i++)
+            cells[i].seq.store(i, std::memory_order_relaxed);
+        head.store(0, std::memory_order_relaxed);
+        tail = 0;
+    }
+
+    bool push(const Record& record) {
+        size_t pos = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & (CAPACITY - 1)];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.record = record;
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;   // full
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop(Record& record) {
+        Cell& cell = cells[tail & (CAPACITY - 1)];
+        if (cell.seq.load(std::memory_order_acquire) != tail + 1)
+            return false;
+        record = cell.record;
+        cell.seq.store(tail + CAPACITY, std::memory_order_release);
+        tail++;
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        Record record;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) size_t tail = 0;
+};
+
+RingBuffer buffer;
+std::thread formatter;
+std::atomic<bool> running{false};
+std::atomic<uint64_t> dropped{0};
+std::ostream* sink = nullptr;
+
+void format(std::ostream& out, const Record& record) {
+    out << '[' << levelName(record.level) << "] " << categoryName(record.category) << ": ";
+
+    int next = 0;
+    for (const char* p = record.format; *p; p++) {
+        if (p[0] == '{' && p[1] == '}' && next < record.argc) {
+            const Arg& a = record.args[next++];
+            switch (a.kind) {
+                case Arg::INT:  out << a.i; break;
+                case Arg::UINT: out << a.u; break;
+                case Arg::REAL: out << a.d; break;
+                case Arg::TEXT: out << a.s; break;
+            }
+            p++;
+        } else {
+            out << *p;
+        }
+    }
+    out << '\n';
+}
+
+void drain() {
+    Record record;
+    for (;;) {
+        while (buffer.pop(record))
+            format(*sink, record);
+
+        // Producers may still be finishing a push after stop() cleared the
+        // thresholds, so only quit on an empty buffer seen after that
+        if (!running.load(std::memory_order_acquire)) {
+            while (buffer.pop(record))
+                format(*sink, record);
+            break;
+        }
+        sink->flush();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    sink->flush();
+}
+
+} // namespace
+
+void submit(const Record& record) {
+    if (!buffer.push(record))
+        dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void start(std::ostream& out, Level level) {
+    stop();
+    buffer.reset();
+    dropped.store(0, std::memory_order_relaxed);
+    sink = &out;
+    running.store(true, std::memory_order_release);
+    formatter = std::thread(drain);
+
+    for (auto& t : thresholds)
+        t.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+}
+
+void stop() {
+    for (auto& t : thresholds)
+        t.store(static_cast<uint8_t>(Level::OFF), std::memory_order_relaxed);
+
+    if (!formatter.joinable()) return;
+    running.store(false, std::memory_order_release);
+    formatter.join();
+
+    if (uint64_t lost = dropped.load(std::memory_order_relaxed))
+        *sink << "[WARN ] log: " << lost << " records dropped (buffer full)\n" << std::flush;
+}
+
+void setLevel(Category category, Level level) {
+    thresholds[static_cast<int>(category)].store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+}
+
+uint64_t droppedCount() {
+    return dropped.load(std::memory_order_relaxed);
+}
+
+} // namespace logging
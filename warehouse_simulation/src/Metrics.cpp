@@ -0,0 +1,185 @@
+#include "Metrics.hpp"
+
+#include <algorithm>
+#include <ostream>
+
+namespace {
+
+const char* counterName(Counter counter) {
+    switch (counter) {
+        case Counter::PATH_SEARCHES: return "path_searches";
+        case Counter::WINDOW_SEARCHES: return "window_searches";
+        case Counter::NODES_EXPANDED: return "nodes_expanded";
+        case Counter::PICKS: return "picks";
+        case Counter::STACKS: return "stacks";
+        case Counter::PIVOTS: return "pivots";
+        case Counter::FIELD_BUILDS: return "field_builds";
+        case Counter::FIELD_REPAIRS: return "field_repairs";
+        case Counter::COUNT: break;
+    }
+    return "unknown";
+}
+
+const char* histogramName(Histogram histogram) {
+    switch (histogram) {
+        case Histogram::NODES_PER_SEARCH: return "nodes_per_search";
+        case Histogram::CONVERSATION_TICKS: return "conversation_ticks";
+        case Histogram::TICK_MICROS: return "tick_us";
+        case Histogram::COUNT: break;
+    }
+    return "unknown";
+}
+
+const char* idleCauseName(IdleCause cause) {
+    switch (cause) {
+        case IdleCause::NO_BOX: return "no_box";
+        case IdleCause::PIVOT_FULL: return "pivot_full";
+        case IdleCause::RESERVATION: return "reservation";
+        case IdleCause::NO_ROUTE: return "no_route";
+        case IdleCause::OTHER: return "other";
+        case IdleCause::COUNT: break;
+    }
+    return "unknown";
+}
+
+size_t bucketOf(long long value) {
+    if (value <= 0) return 0;
+    size_t bucket = 64 - static_cast<size_t>(__builtin_clzll(static_cast<unsigned long long>(value)));
+    return bucket < Metrics::BUCKETS ? bucket : Metrics::BUCKETS - 1;
+}
+
+long long bucketLimit(size_t bucket) {
+    return bucket == 0 ? 0 : (1LL << bucket) - 1;
+}
+
+} // namespace
+
+size_t Metrics::threadShard() {
+    static std::atomic<size_t> nextThread{0};
+    thread_local size_t shard = nextThread.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+    return shard;
+}
+
+Metrics::Metrics() : shards(new Shard[SHARDS]) {}
+
+Metrics::Shard& Metrics::local() {
+    return shards[threadShard()];
+}
+
+void Metrics::add(Counter counter, long long amount) {
+    local().counters[static_cast<size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+}
+
+void Metrics::record(Histogram histogram, long long value) {
+    Hist& h = local().histograms[static_cast<size_t>(histogram)];
+    h.count.fetch_add(1, std::memory_order_relaxed);
+    h.sum.fetch_add(value, std::memory_order_relaxed);
+    h.buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+
+    // Another thread only shares the shard past SHARDS threads, so this
+    // rarely loops more than once
+    long long seen = h.max.load(std::memory_order_relaxed);
+    while (value > seen && !h.max.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+}
+
+void Metrics::countMessage(acl::Performative performative, size_t receivers) {
+    Shard& s = local();
+    size_t p = static_cast<size_t>(performative);
+    s.sent[p].fetch_add(1, std::memory_order_relaxed);
+    s.delivered[p].fetch_add(static_cast<long long>(receivers), std::memory_order_relaxed);
+}
+
+void Metrics::idle(acl::AgentId robot, IdleCause cause) {
+    if (robot >= robotIdle.size())
+        robotIdle.resize(robot + 1, {});
+    robotIdle[robot][static_cast<size_t>(cause)]++;
+}
+
+long long Metrics::total(Counter counter) const {
+    long long sum = 0;
+    for (size_t i = 0; i < SHARDS; i++)
+        sum += shards[i].counters[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+    return sum;
+}
+
+long long Metrics::messages(acl::Performative performative) const {
+    long long sum = 0;
+    for (size_t i = 0; i < SHARDS; i++)
+        sum += shards[i].sent[static_cast<size_t>(performative)].load(std::memory_order_relaxed);
+    return sum;
+}
+
+Metrics::Summary Metrics::summary(Histogram histogram) const {
+    Summary s;
+    for (size_t i = 0; i < SHARDS; i++) {
+        const Hist& h = shards[i].histograms[static_cast<size_t>(histogram)];
+        s.count += h.count.load(std::memory_order_relaxed);
+        s.sum += h.sum.load(std::memory_order_relaxed);
+        s.max = std::max(s.max, h.max.load(std::memory_order_relaxed));
+        for (size_t b = 0; b < BUCKETS; b++)
+            s.buckets[b] += h.buckets[b].load(std::memory_order_relaxed);
+    }
+    return s;
+}
+
+long long Metrics::Summary::percentile(double p) const {
+    if (count == 0) return 0;
+    long long rank = static_cast<long long>(p * static_cast<double>(count - 1)) + 1;
+    long long seen = 0;
+    for (size_t b = 0; b < BUCKETS; b++) {
+        seen += buckets[b];
+        if (seen >= rank)
+            return std::min(bucketLimit(b), max);
+    }
+    return max;
+}
+
+void Metrics::writeJson(std::ostream& out, long long tick) const {
+    out << "{\"tick\":" << tick << ",\"counters\":{";
+    for (size_t c = 0; c < static_cast<size_t>(Counter::COUNT); c++) {
+        if (c) out << ',';
+        out << '"' << counterName(static_cast<Counter>(c)) << "\":" << total(static_cast<Counter>(c));
+    }
+
+    // Envelopes sent and the copies they fanned out to
+    out << "},\"messages\":{";
+    for (size_t p = 0; p < PERFORMATIVE_COUNT; p++) {
+        long long sent = 0, delivered = 0;
+        for (size_t i = 0; i < SHARDS; i++) {
+            sent += shards[i].sent[p].load(std::memory_order_relaxed);
+            delivered += shards[i].delivered[p].load(std::memory_order_relaxed);
+        }
+        if (p) out << ',';
+        out << '"' << acl::performativeName(static_cast<acl::Performative>(p)) << "\":{\"sent\":" << sent
+            << ",\"delivered\":" << delivered << '}';
+    }
+
+    out << "},\"histograms\":{";
+    for (size_t h = 0; h < static_cast<size_t>(Histogram::COUNT); h++) {
+        Summary s = summary(static_cast<Histogram>(h));
+        if (h) out << ',';
+        out << '"' << histogramName(static_cast<Histogram>(h)) << "\":{\"count\":" << s.count
+            << ",\"mean\":" << (s.count ? static_cast<double>(s.sum) / static_cast<double>(s.count) : 0.0)
+            << ",\"p50\":" << s.percentile(0.5) << ",\"p90\":" << s.percentile(0.9)
+            << ",\"p99\":" << s.percentile(0.99) << ",\"max\":" << s.max << ",\"buckets\":[";
+
+        // [upper bound, count] for every non-empty bucket
+        bool first = true;
+        for (size_t b = 0; b < BUCKETS; b++) {
+            if (!s.buckets[b]) continue;
+            out << (first ? "" : ",") << '[' << bucketLimit(b) << ',' << s.buckets[b] << ']';
+            first = false;
+        }
+        out << "]}";
+    }
+
+    out << "},\"idle_ticks\":[";
+    for (size_t r = 0; r < robotIdle.size(); r++) {
+        if (r) out << ',';
+        out << "{\"robot\":" << r;
+        for (size_t c = 0; c < static_cast<size_t>(IdleCause::COUNT); c++)
+            out << ",\"" << idleCauseName(static_cast<IdleCause>(c)) << "\":" << robotIdle[r][c];
+        out << '}';
+    }
+    out << "]}\n";
+}
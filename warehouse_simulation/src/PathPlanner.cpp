@@ -0,0 +1,339 @@
+#include "PathPlanner.hpp"
+#include "HierarchicalPlanner.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+bool heapAfter(const SearchWorkspace::OpenEntry& a, const SearchWorkspace::OpenEntry& b) {
+    // Min-heap on f; on ties prefer the deeper node, it is closer to the goal
+    if (a.f != b.f) return a.f > b.f;
+    return a.g < b.g;
+}
+
+// Cell is passable for a path towards `goal`
+inline bool passable(const Grid& grid, int idx, int goal) {
+    return !grid.isWall(idx) && (!grid.hasBox(idx) || idx == goal);
+}
+
+inline int manhattan(const Grid& grid, int a, int b) {
+    int stride = grid.rowStride();
+    return std::abs(a % stride - b % stride) + std::abs(a / stride - b / stride);
+}
+
+// Walks the parent chain from goal back to start, filling in the straight
+// runs between consecutive nodes (jump points are not adjacent)
+void buildPath(const Grid& grid, const SearchWorkspace& ws, int start, int goal, std::vector<Pos>& path) {
+    path.clear();
+    int stride = grid.rowStride();
+
+    for (int cur = goal; cur != start; ) {
+        int from = ws.parentOf(cur);
+        int step = (std::abs(cur - from) < stride) ? (cur > from ? 1 : -1)
+                                                   : (cur > from ? stride : -stride);
+        for (int c = cur; c != from; c -= step)
+            path.push_back({grid.xOf(c), grid.yOf(c)});
+        cur = from;
+    }
+    std::reverse(path.begin(), path.end());
+}
+
+class DijkstraPlanner : public PathPlanner {
+public:
+    bool findPath(const Grid& grid, Pos start, Pos goal,
+                  std::vector<Pos>& path, SearchStats* stats) const override {
+        path = computeDijkstraPath(grid, start.first, start.second, goal.first, goal.second,
+                                   stats ? &stats->expanded : nullptr);
+        return !path.empty();
+    }
+
+    PlannerKind kind() const override { return PlannerKind::DIJKSTRA; }
+};
+
+class AStarPlanner : public PathPlanner {
+public:
+    bool findPath(const Grid& grid, Pos startPos, Pos goalPos,
+                  std::vector<Pos>& path, SearchStats* stats) const override {
+        path.clear();
+        if (!grid.inBounds(startPos.first, startPos.second) || !grid.inBounds(goalPos.first, goalPos.second))
+            return false;
+
+        const int start = grid.index(startPos.first, startPos.second);
+        const int goal = grid.index(goalPos.first, goalPos.second);
+        const int* offsets = grid.neighborOffsets();
+
+        SearchWorkspace& ws = SearchWorkspace::local();
+        ws.begin(grid.cellCount());
+        ws.open(start, 0, manhattan(grid, start, goal), start);
+
+        int expanded = 0;
+        bool found = false;
+
+        while (!ws.empty()) {
+            SearchWorkspace::OpenEntry e = ws.pop();
+            if (ws.closed(e.idx) || e.g > ws.g(e.idx)) continue;
+            ws.close(e.idx);
+            expanded++;
+
+            if (e.idx == goal) {
+                found = true;
+                break;
+            }
+
+            for (int i = 0; i < 4; i++) {
+                int next = e.idx + offsets[i];
+                if (!passable(grid, next, goal)) continue;
+
+                int ng = e.g + 1;
+                if (!ws.seen(next) || ng < ws.g(next))
+                    ws.open(next, ng, ng + manhattan(grid, next, goal), e.idx);
+            }
+        }
+
+        if (stats) stats->expanded += expanded;
+        if (!found || start == goal) return false;
+
+        buildPath(grid, ws, start, goal, path);
+        return true;
+    }
+
+    PlannerKind kind() const override { return PlannerKind::ASTAR; }
+};
+
+// Jump Point Search for 4-connected grids.
+//
+// Canonical paths only turn from horizontal to vertical where an obstacle
+// forces it, and may turn from vertical to horizontal anywhere. So a
+// horizontal run keeps going until it hits the goal, a wall or a forced
+// vertical neighbour, and a vertical run stops wherever a horizontal run
+// from it would find something. Horizontal runs are scanned 64 cells at a
+// time from the row-major bitmask layers.
+class JpsPlanner : public PathPlanner {
+public:
+    bool findPath(const Grid& grid, Pos startPos, Pos goalPos,
+                  std::vector<Pos>& path, SearchStats* stats) const override {
+        path.clear();
+        if (!grid.inBounds(startPos.first, startPos.second) || !grid.inBounds(goalPos.first, goalPos.second))
+            return false;
+
+        Search s{grid, grid.index(startPos.first, startPos.second),
+                 grid.index(goalPos.first, goalPos.second), grid.rowStride()};
+        if (grid.isWall(s.goal) || s.start == s.goal) return false;
+
+        SearchWorkspace& ws = SearchWorkspace::local();
+        ws.begin(grid.cellCount());
+        ws.open(s.start, 0, manhattan(grid, s.start, s.goal), s.start);
+
+        int expanded = 0;
+        bool found = false;
+
+        while (!ws.empty()) {
+            SearchWorkspace::OpenEntry e = ws.pop();
+            if (ws.closed(e.idx) || e.g > ws.g(e.idx)) continue;
+            ws.close(e.idx);
+            expanded++;
+
+            if (e.idx == s.goal) {
+                found = true;
+                break;
+            }
+
+            int successors[4];
+            int count = s.successors(e.idx, ws.parentOf(e.idx), successors);
+
+            for (int i = 0; i < count; i++) {
+                int next = successors[i];
+                int ng = e.g + manhattan(grid, e.idx, next);
+                if (!ws.seen(next) || ng < ws.g(next))
+                    ws.open(next, ng, ng + manhattan(grid, next, s.goal), e.idx);
+            }
+        }
+
+        if (stats) stats->expanded += expanded;
+        if (!found) return false;
+
+        buildPath(grid, ws, s.start, s.goal, path);
+        return true;
+    }
+
+    PlannerKind kind() const override { return PlannerKind::JPS; }
+
+private:
+    struct Search {
+        const Grid& grid;
+        int start;
+        int goal;
+        int stride;
+
+        static uint64_t loadBits(const CellArray<uint64_t>& mask, int from) {
+            if (from < 0) {
+                if (from <= -64) return 0;
+                return loadBits(mask, 0) << (-from);
+            }
+            size_t word = static_cast<size_t>(from) >> 6;
+            int offset = from & 63;
+            if (word >= mask.size()) return 0;
+            uint64_t bits = mask[word] >> offset;
+            if (offset && word + 1 < mask.size())
+                bits |= mask[word + 1] << (64 - offset);
+            return bits;
+        }
+
+        // Blocked cells in [from, from + 64); the goal never counts as blocked
+        uint64_t blockedFrom(int from) const {
+            uint64_t bits = loadBits(grid.wallMask(), from);
+            uint64_t boxes = loadBits(grid.boxMask(), from);
+            if (goal >= from && goal < from + 64)
+                boxes &= ~(uint64_t(1) << (goal - from));
+            return bits | boxes;
+        }
+
+        uint64_t goalBitFrom(int from) const {
+            return (goal >= from && goal < from + 64) ? uint64_t(1) << (goal - from) : 0;
+        }
+
+        bool blocked(int idx) const { return !passable(grid, idx, goal); }
+
+        // Horizontal run from `from`; returns the jump point or -1
+        int jumpHorizontal(int from, int dx) const {
+            if (dx > 0) {
+                // Bit k of each window is cell (first + k)
+                for (int first = from + 1; ; first += 64) {
+                    uint64_t wall = blockedFrom(first);
+                    uint64_t forced = (blockedFrom(first - 1 - stride) & ~blockedFrom(first - stride)) |
+                                      (blockedFrom(first - 1 + stride) & ~blockedFrom(first + stride));
+                    uint64_t stop = wall | forced | goalBitFrom(first);
+                    if (!stop) continue;
+
+                    int k = __builtin_ctzll(stop);
+                    return ((wall >> k) & 1) ? -1 : first + k;
+                }
+            }
+
+            // Bit k of each window is cell (last - 63 + k); scan from the top bit down
+            for (int last = from - 1; ; last -= 64) {
+                int first = last - 63;
+                uint64_t wall = blockedFrom(first);
+                uint64_t forced = (blockedFrom(first + 1 - stride) & ~blockedFrom(first - stride)) |
+                                  (blockedFrom(first + 1 + stride) & ~blockedFrom(first + stride));
+                uint64_t stop = wall | forced | goalBitFrom(first);
+                if (!stop) continue;
+
+                int k = 63 - __builtin_clzll(stop);
+                return ((wall >> k) & 1) ? -1 : first + k;
+            }
+        }
+
+        // Vertical run from `from`; stops where a horizontal run finds something
+        int jumpVertical(int from, int dy) const {
+            int step = dy * stride;
+            for (int cur = from + step; ; cur += step) {
+                if (blocked(cur)) return -1;
+                if (cur == goal) return cur;
+                if (jumpHorizontal(cur, 1) >= 0 || jumpHorizontal(cur, -1) >= 0)
+                    return cur;
+            }
+        }
+
+        int successors(int node, int parent, int* out) const {
+            int count = 0;
+            auto add = [&](int jp) { if (jp >= 0) out[count++] = jp; };
+
+            if (node == parent) {
+                // Start node: every direction
+                add(jumpHorizontal(node, 1));
+                add(jumpHorizontal(node, -1));
+                add(jumpVertical(node, 1));
+                add(jumpVertical(node, -1));
+                return count;
+            }
+
+            int delta = node - parent;
+            if (std::abs(delta) < stride) {
+                // Arrived horizontally: keep going, plus any forced turn
+                int dx = delta > 0 ? 1 : -1;
+                add(jumpHorizontal(node, dx));
+                for (int dy = -1; dy <= 1; dy += 2) {
+                    int side = node + dy * stride;
+                    if (blocked(side - dx) && !blocked(side))
+                        add(jumpVertical(node, dy));
+                }
+            } else {
+                // Arrived vertically: keep going or turn either way
+                int dy = delta > 0 ? 1 : -1;
+                add(jumpVertical(node, dy));
+                add(jumpHorizontal(node, 1));
+                add(jumpHorizontal(node, -1));
+            }
+            return count;
+        }
+    };
+};
+
+} // namespace
+
+SearchWorkspace& SearchWorkspace::local() {
+    thread_local SearchWorkspace workspace;
+    return workspace;
+}
+
+void SearchWorkspace::begin(int cellCount) {
+    if (static_cast<int>(stamp.size()) < cellCount) {
+        stamp.assign(cellCount, 0);
+        closedStamp.assign(cellCount, 0);
+        gScore.resize(cellCount);
+        parent.resize(cellCount);
+        generation = 0;
+    }
+
+    heap.clear();
+    if (++generation == 0) {
+        // Wrapped around: old stamps could look current again
+        std::fill(stamp.begin(), stamp.end(), 0);
+        std::fill(closedStamp.begin(), closedStamp.end(), 0);
+        generation = 1;
+    }
+}
+
+void SearchWorkspace::push(const OpenEntry& e) {
+    heap.push_back(e);
+    std::push_heap(heap.begin(), heap.end(), heapAfter);
+}
+
+SearchWorkspace::OpenEntry SearchWorkspace::pop() {
+    std::pop_heap(heap.begin(), heap.end(), heapAfter);
+    OpenEntry e = heap.back();
+    heap.pop_back();
+    return e;
+}
+
+bool parsePlannerKind(const std::string& text, PlannerKind& kind) {
+    if (text == "dijkstra") kind = PlannerKind::DIJKSTRA;
+    else if (text == "astar") kind = PlannerKind::ASTAR;
+    else if (text == "jps") kind = PlannerKind::JPS;
+    else if (text == "hpa") kind = PlannerKind::HPA;
+    else return false;
+    return true;
+}
+
+const char* plannerKindName(PlannerKind kind) {
+    switch (kind) {
+        case PlannerKind::DIJKSTRA: return "dijkstra";
+        case PlannerKind::ASTAR: return "astar";
+        case PlannerKind::JPS: return "jps";
+        case PlannerKind::HPA: return "hpa";
+    }
+    return "unknown";
+}
+
+std::unique_ptr<PathPlanner> makePlanner(PlannerKind kind) {
+    switch (kind) {
+        case PlannerKind::DIJKSTRA: return std::make_unique<DijkstraPlanner>();
+        case PlannerKind::ASTAR: return std::make_unique<AStarPlanner>();
+        case PlannerKind::JPS: return std::make_unique<JpsPlanner>();
+        case PlannerKind::HPA: return std::make_unique<HierarchicalPlanner>();
+    }
+    return nullptr;
+}
@@ -0,0 +1,211 @@
+#include "PivotManager.hpp"
+#include "Log.hpp"
+#include "SimulationContext.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+
+namespace {
+
+int manhattan(Pos a, Pos b) {
+    return std::abs(a.first - b.first) + std::abs(a.second - b.second);
+}
+
+} // namespace
+
+int PivotManager::freeSides(const Grid& grid, int idx, const Robot* standing) const {
+    const CooperativePlanner* cooperative = context.getCooperative();
+    int sides = 0;
+    for (int i = 0; i < 4; i++) {
+        int side = idx + grid.neighborOffsets()[i];
+        if (grid.isBlocked(side)) continue;
+        if (cooperative) {
+            const Robot* parked = cooperative->table().parkedOn(side, context.getTick());
+            if (parked && parked != standing) continue;
+        }
+        sides++;
+    }
+    return sides;
+}
+
+bool PivotManager::mayOpen(const Grid& grid, BoxHandle box, const Robot* standing) const {
+    const Box* b = grid.box(box);
+    if (!context.getCooperative() || freeSides(grid, grid.index(b->x, b->y), standing) >= ROOMY_SIDES)
+        return true;
+
+    const BoxStore& store = grid.boxStore();
+    const auto& robots = context.getRobots();
+    for (size_t i = 0; i < store.size(); i++) {
+        const Box& other = store.at(i);
+        BoxHandle handle = store.handleAt(i);
+        int idx = grid.index(other.x, other.y);
+        if (handle == box || other.isPivot || other.stackSize != 1 || grid.boxAt(idx) != handle) continue;
+        if (freeSides(grid, idx, nullptr) < ROOMY_SIDES) continue;
+        if (std::none_of(robots.begin(), robots.end(),
+                         [&](const std::unique_ptr<Robot>& r) { return r->wants(handle); }))
+            return false;
+    }
+    return true;
+}
+
+void PivotManager::open(Grid& grid, BoxHandle handle, int slot) {
+    Box* box = grid.box(handle);
+    WLOG_INFO(ROBOT, "box ({},{}) set as pivot", box->x, box->y);
+    box->isPivot = true;
+    context.getMemory().setPivot(slot, handle);
+    context.getMetrics().add(Counter::PIVOTS);
+    if (TraceRecorder* trace = context.getTrace())
+        trace->pivot(box->x, box->y, true);
+}
+
+int PivotManager::bestPivotFor(const Grid& grid, int cell) {
+    SharedMemory& memory = context.getMemory();
+
+    std::vector<int> roomy;
+    for (int slot = 0; slot < memory.pivotSlots(); slot++) {
+        const Box* pivot = grid.box(memory.getPivot(slot));
+        if (pivot && pivot->stackSize + memory.boxesGoingToPivot(slot) < Box::MAX_STACK)
+            roomy.push_back(slot);
+    }
+    if (roomy.size() < 2)
+        return roomy.empty() ? -1 : roomy.front();
+
+    // Steps along the pivots' shared fields, so a pivot behind a wall is
+    // not mistaken for a close one
+    int best = -1;
+    int bestSteps = INT_MAX;
+    for (int slot : roomy) {
+        const Box* pivot = grid.box(memory.getPivot(slot));
+        int steps = context.getFlowFields().toward(grid.index(pivot->x, pivot->y)).distance(cell);
+        if (steps >= 0 && steps < bestSteps) {
+            best = slot;
+            bestSteps = steps;
+        }
+    }
+    return best;
+}
+
+void PivotManager::openPivots(Grid& grid) {
+    SharedMemory& memory = context.getMemory();
+    if (memory.pivotSlots() < 2 || memory.freePivotSlot() < 0) return;
+
+    // Loose boxes: on the floor and not stacked onto yet, in cell order so
+    // ties break the same way every run
+    const BoxStore& store = grid.boxStore();
+    std::vector<std::pair<int, BoxHandle>> loose;
+    int singles = 0;
+    for (size_t i = 0; i < store.size(); i++) {
+        const Box& box = store.at(i);
+        BoxHandle handle = store.handleAt(i);
+        int idx = grid.index(box.x, box.y);
+        if (box.isPivot || box.stackSize >= Box::MAX_STACK || grid.boxAt(idx) != handle) continue;
+        loose.push_back({idx, handle});
+        if (box.stackSize == 1) singles++;
+    }
+    std::sort(loose.begin(), loose.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    // Room left on the open pivots; a new one is only worth it for the boxes
+    // that do not fit there
+    std::vector<Pos> centres;
+    int room = 0;
+    int free = 0;
+    for (int slot = 0; slot < memory.pivotSlots(); slot++) {
+        const Box* pivot = grid.box(memory.getPivot(slot));
+        if (!pivot) {
+            free++;
+            continue;
+        }
+        room += std::max(0, Box::MAX_STACK - pivot->stackSize - memory.boxesGoingToPivot(slot));
+        centres.push_back({pivot->x, pivot->y});
+    }
+    int wanted = std::min(free, (singles - room + Box::MAX_STACK - 1) / Box::MAX_STACK);
+    if (wanted <= 0) return;
+
+    auto posOf = [&](size_t i) { return Pos(grid.xOf(loose[i].first), grid.yOf(loose[i].first)); };
+    auto nearestCentre = [&](Pos p) {
+        size_t best = 0;
+        for (size_t c = 1; c < centres.size(); c++)
+            if (manhattan(p, centres[c]) < manhattan(p, centres[best]))
+                best = c;
+        return best;
+    };
+
+    // Seed the new centres: the first (when nothing is open) in the middle of
+    // the loose boxes, every other one on the box farthest from all centres
+    size_t fixed = centres.size();
+    if (centres.empty()) {
+        long long sx = 0, sy = 0;
+        for (size_t i = 0; i < loose.size(); i++) {
+            sx += posOf(i).first;
+            sy += posOf(i).second;
+        }
+        centres.push_back({static_cast<int>(sx / static_cast<long long>(loose.size())),
+                           static_cast<int>(sy / static_cast<long long>(loose.size()))});
+    }
+    while (centres.size() < fixed + static_cast<size_t>(wanted)) {
+        size_t far = 0;
+        int farthest = -1;
+        for (size_t i = 0; i < loose.size(); i++) {
+            int d = manhattan(posOf(i), centres[nearestCentre(posOf(i))]);
+            if (d > farthest) {
+                farthest = d;
+                far = i;
+            }
+        }
+        if (farthest <= 0) break;      // fewer distinct spots than pivots wanted
+        centres.push_back(posOf(far));
+    }
+
+    // Move the new centres into their clusters; open pivots stay where they are
+    std::vector<size_t> owner(loose.size(), SIZE_MAX);
+    for (int round = 0; round < KMEANS_ROUNDS; round++) {
+        bool moved = false;
+        for (size_t i = 0; i < loose.size(); i++) {
+            size_t c = nearestCentre(posOf(i));
+            moved |= owner[i] != c;
+            owner[i] = c;
+        }
+        if (!moved) break;
+
+        for (size_t c = fixed; c < centres.size(); c++) {
+            long long sx = 0, sy = 0, n = 0;
+            for (size_t i = 0; i < loose.size(); i++) {
+                if (owner[i] != c) continue;
+                sx += posOf(i).first;
+                sy += posOf(i).second;
+                n++;
+            }
+            if (n > 0) centres[c] = {static_cast<int>(sx / n), static_cast<int>(sy / n)};
+        }
+    }
+
+    // Each new centre opens on the box of its cluster nearest to it that no
+    // robot is after and that a robot can get beside. Cooperative robots
+    // cannot pass each other, so a box with a single free side would trap
+    // whoever stacks there behind whoever comes next: those only open when
+    // the cluster has nothing roomier.
+    const auto& robots = context.getRobots();
+    int roomySides = context.getCooperative() ? ROOMY_SIDES : 1;
+    for (size_t c = fixed; c < centres.size(); c++) {
+        size_t pick = SIZE_MAX;
+        std::pair<bool, int> pickKey;       // (cramped, distance to the centre)
+        for (size_t i = 0; i < loose.size(); i++) {
+            if (owner[i] != c) continue;
+            int sides = freeSides(grid, loose[i].first, nullptr);
+            if (sides == 0) continue;
+            std::pair<bool, int> key = {sides < roomySides, manhattan(posOf(i), centres[c])};
+            if (pick != SIZE_MAX && key >= pickKey) continue;
+            bool claimed = std::any_of(robots.begin(), robots.end(),
+                                       [&](const std::unique_ptr<Robot>& r) { return r->wants(loose[i].second); });
+            if (!claimed) {
+                pick = i;
+                pickKey = key;
+            }
+        }
+        int slot = memory.freePivotSlot();
+        if (pick == SIZE_MAX || slot < 0) continue;
+        open(grid, loose[pick].second, slot);
+    }
+}
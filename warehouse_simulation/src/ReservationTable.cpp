@@ -0,0 +1,85 @@
+#include "ReservationTable.hpp"
+
+#include <algorithm>
+
+ReservationTable::ReservationTable(int cellCount)
+: cells(cellCount), parking(cellCount) {}
+
+const Robot* ReservationTable::holder(int idx, long long tick) const {
+    auto it = slots.find(key(idx, tick));
+    if (it != slots.end())
+        return it->second;
+
+    const Parking& p = parking[idx];
+    if (p.robot && tick >= p.from)
+        return p.robot;
+    return nullptr;
+}
+
+bool ReservationTable::swapConflict(int from, int to, long long tick, const Robot* self) const {
+    if (from == to) return false;
+    const Robot* other = holder(to, tick);
+    return other && other != self && holder(from, tick + 1) == other;
+}
+
+bool ReservationTable::canPark(int idx, long long from, const Robot* self) const {
+    const Parking& p = parking[idx];
+    if (p.robot && p.robot != self)
+        return false;
+
+    for (long long t = from; t <= horizon; t++) {
+        auto it = slots.find(key(idx, t));
+        if (it != slots.end() && it->second != self)
+            return false;
+    }
+    return true;
+}
+
+void ReservationTable::reserve(int idx, long long tick, const Robot* self) {
+    uint64_t k = key(idx, tick);
+    slots[k] = self;
+    held[self].push_back(k);
+    horizon = std::max(horizon, tick);
+}
+
+void ReservationTable::park(int idx, long long from, const Robot* self) {
+    auto it = parkedAt.find(self);
+    if (it != parkedAt.end())
+        parking[it->second] = Parking();
+
+    parking[idx] = {self, from};
+    parkedAt[self] = idx;
+}
+
+void ReservationTable::askToYield(const Robot* parked, const YieldRequest& ask) {
+    auto [it, inserted] = yieldRequests.emplace(parked, ask);
+    if (!inserted && it->second.priority < ask.priority)
+        it->second = ask;
+}
+
+bool ReservationTable::takeYieldRequest(const Robot* self, YieldRequest& request) {
+    auto it = yieldRequests.find(self);
+    if (it == yieldRequests.end())
+        return false;
+    request = std::move(it->second);
+    yieldRequests.erase(it);
+    return true;
+}
+
+void ReservationTable::release(const Robot* self) {
+    auto it = held.find(self);
+    if (it != held.end()) {
+        for (uint64_t k : it->second) {
+            auto slot = slots.find(k);
+            if (slot != slots.end() && slot->second == self)
+                slots.erase(slot);
+        }
+        it->second.clear();
+    }
+
+    auto p = parkedAt.find(self);
+    if (p != parkedAt.end()) {
+        parking[p->second] = Parking();
+        parkedAt.erase(p);
+    }
+}
@@ -1,56 +1,89 @@
 #include "Robot.hpp"
-#include <SFML/Window/Keyboard.hpp>
 #include "SharedMemory.hpp"
-#include "utils.hpp"
+#include "SimulationContext.hpp"
+#include "CooperativePlanner.hpp"
+#include "Log.hpp"
 
-#include <iostream>
-#include <chrono>
+#include <algorithm>
+#include <deque>
+#include <queue>
 #include <unordered_map>
 
-Robot::Robot(const std::string& name, int startX, int startY)
-    : Agent(name), x(startX), y(startY),
-      carrying(false), carriedBox(nullptr),
-      state(MOVING_TO_BOX) {}
+namespace {
 
-bool Robot::inBounds(const Grid& grid, int nx, int ny) {
-    return ny >= 0 && ny < grid.rows &&
-           nx >= 0 && nx < grid.cols;
+bool besideBox(const Grid& grid, int idx) {
+    for (int i = 0; i < 4; i++)
+        if (grid.hasBox(idx + grid.neighborOffsets()[i]))
+            return true;
+    return false;
 }
 
-bool Robot::checkBoxAvailability(Box* box, const std::vector<Robot*>& robots) {
-    if (!box) return false;
-
-    std::string convId = generateUniqueConversationId();
-    pendingRequests[convId] = false;
+bool contains(const std::vector<int>& cells, int idx) {
+    return std::find(cells.begin(), cells.end(), idx) != cells.end();
+}
 
-    int expectedResponses = 0;
-    waitingForResponses[convId] = 0;
+} // namespace
 
-    std::string queryContent = "available? box(" + std::to_string(box->x) + "," + std::to_string(box->y) + ")";
+Robot::Robot(const std::string& name, int startX, int startY, SimulationContext& context)
+    : Agent(name, context.getRegistry()), x(startX), y(startY),
+      carrying(false),
+      state(MOVING_TO_BOX), context(context) {
+    if (context.getConfig().replan == ReplanMode::INCREMENTAL)
+        incremental = std::make_unique<DStarLite>(context.getGrid());
 
-    for (const auto& r : robots) {
-        if (r == this) continue;
-        sendRequest(r->name, queryContent, convId);
-        expectedResponses++;
+    // Hold the spawn cell until the first window is planned
+    if (CooperativePlanner* coop = context.getCooperative()) {
+        windowStart = {x, y};
+        windowTick = context.getTick();
+        coop->commit(context.getGrid(), this, windowStart, windowTick, windowSteps);
     }
+}
 
-    waitingForResponses[convId] = expectedResponses;
+void Robot::startAvailabilityQuery(const Grid& grid, BoxHandle box) {
+    const Box* b = grid.box(box);
+    acl::ConversationId convId = negotiations.callForProposals(
+        acl::BoxQuery{b->x, b->y},
+        context.getTick(),
+        context.getTick() + QUERY_TIMEOUT_TICKS,
+        [this](const acl::Negotiation& n) { onAvailabilityAnswered(n); });
+    if (!convId) return;
+
+    candidateBox = box;
+    candidatePos = {b->x, b->y};
+    queryConvId = convId;
+}
 
-    auto start = std::chrono::steady_clock::now();
-    while (waitingForResponses[convId] > 0) {
-        auto now = std::chrono::steady_clock::now();
-        auto diff = std::chrono::duration_cast<std::chrono::milliseconds>(now - start);
-        if (diff.count() > 100) break;  // timeout
-    }
+void Robot::onAvailabilityAnswered(const acl::Negotiation& negotiation) {
+    context.getMetrics().record(Histogram::CONVERSATION_TICKS, context.getTick() - negotiation.started);
 
-    bool answered = pendingRequests[convId];
-    pendingRequests.erase(convId);
-    waitingForResponses.erase(convId);
+    // Peers that stay silent past the deadline are taken as not objecting
+    bool available = negotiation.refusals == 0;
 
-    return answered;
+    // A peer may have won the same box while our replies were in flight
+    if (available && isBoxTargetedByOthers(candidateBox, context.getGrid().getRobots()))
+        available = false;
+
+    if (available) {
+        WLOG_INFO(ACL, "robot #{} won box ({},{})", id, candidatePos.first, candidatePos.second);
+        targetBox = candidateBox;
+        rejectedBoxes.clear();
+    } else {
+        WLOG_DEBUG(ACL, "robot #{} lost box ({},{}): {} refusals", id, candidatePos.first, candidatePos.second,
+                   negotiation.refusals);
+        rejectedBoxes.push_back(candidateBox);
+    }
+    candidateBox = BoxHandle();
+    queryConvId = 0;
 }
 
-bool Robot::isBoxTargetedByOthers(Box* box, const std::vector<Robot*>& allRobots) {
+void Robot::assignTask(BoxHandle box) {
+    [[maybe_unused]] const Box* b = context.getGrid().box(box);
+    WLOG_INFO(ROBOT, "robot #{} assigned box ({},{})", id, b->x, b->y);
+    targetBox = box;
+    rejectedBoxes.clear();
+}
+
+bool Robot::isBoxTargetedByOthers(BoxHandle box, const std::vector<Robot*>& allRobots) {
     for (auto r : allRobots) {
         if (r == this) continue;
         if (r->targetBox == box)
@@ -59,65 +92,144 @@ bool Robot::isBoxTargetedByOthers(Box* box, const std::vector<Robot*>& allRobots
     return false;
 }
 
-Box* Robot::findNearestNonPivotBox(Grid& grid, const std::vector<Robot*>& allRobots) {
-    struct Candidate {
-        Box* box;
-        int dist;
+BoxHandle Robot::findNearestNonPivotBox(Grid& grid, const std::vector<Robot*>& allRobots) {
+    int maxStack = Box::targetLimit(context.getMemory().pivotExists());
+    BoxFilter filter;
+    filter.maxStack = maxStack;
+    filter.skipPivots = true;
+    filter.accept = [&](BoxHandle handle, [[maybe_unused]] const Box& box) {
+        if (std::find(rejectedBoxes.begin(), rejectedBoxes.end(), handle) != rejectedBoxes.end())
+            return false;
+
+        if (isBoxTargetedByOthers(handle, allRobots)) {
+            WLOG_TRACE(ROBOT, "box ({},{}) is already targeted by another robot", box.x, box.y);
+            return false;
+        }
+        return true;
     };
 
-    std::vector<Candidate> candidates;
+    // Boxes sensed in the plan phase are still in nearest-first order; the
+    // first one that passes every filter now is the answer
+    if (hasSensedBoxes && sensedFrom == Pos(x, y)) {
+        hasSensedBoxes = false;
+        for (BoxHandle handle : sensedBoxes) {
+            const Box* box = grid.box(handle);
+            if (!box || grid.boxAt(box->x, box->y) != handle || box->stackSize >= maxStack || box->isPivot)
+                continue;
+            if (filter.accept(handle, *box))
+                return handle;
+        }
+    }
+
+    // The tile index stops at the first ring that cannot hold anything closer
+    std::vector<BoxHandle> nearest;
+    if (grid.boxIndex().nearest(x, y, 1, filter, nearest) == 0)
+        return BoxHandle();
+    return nearest.front();
+}
+
+void Robot::computeRoute(const Grid& grid, const Pos& target, std::vector<Pos>& path) {
+    SearchStats stats;
+    if (incremental)
+        incremental->plan({x, y}, target, path, &stats);
+    else
+        context.getPlanner().findPath(grid, {x, y}, target, path, &stats);
+    countSearch(Counter::PATH_SEARCHES, stats);
+}
+
+void Robot::countSearch(Counter kind, const SearchStats& stats) {
+    Metrics& metrics = context.getMetrics();
+    metrics.add(kind);
+    metrics.add(Counter::NODES_EXPANDED, stats.expanded);
+    metrics.record(Histogram::NODES_PER_SEARCH, stats.expanded);
+}
 
-    for (int row = 0; row < grid.rows; row++) {
-        for (int col = 0; col < grid.cols; col++) {
-            Box* box = grid.cells[row][col].box;
-            if (!box) continue;
-            if (box->stackSize >= 5) continue;
-            if (box->isPivot) continue;
+void Robot::planRoute(const Grid& grid, const Pos& target) {
+    if (preparedRouteFor(target))
+        currentPath.swap(preparedPath);
+    else
+        computeRoute(grid, target, currentPath);
+    hasPreparedRoute = false;
+    currentTarget = target;
+}
 
-            int dist = abs(col - x) + abs(row - y);
-            candidates.push_back({box, dist});
+bool Robot::upcomingGoal(const Grid& grid, Pos& target) {
+    if (state == MOVING_TO_BOX) {
+        if (const Box* box = grid.box(targetBox)) {
+            target = {box->x, box->y};
+            return true;
+        }
+        if (candidateBox) {
+            target = candidatePos;
+            return true;
+        }
+    } else if (state == MOVING_TO_PIVOT) {
+        if (const Box* pivot = reservedPivot(grid)) {
+            target = {pivot->x, pivot->y};
+            return true;
         }
     }
+    return false;
+}
 
-    std::sort(candidates.begin(), candidates.end(),
-              [](const Candidate& a, const Candidate& b) {
-                  return a.dist < b.dist;
-              });
-
-    for (const auto& c : candidates) {
-        if (!isBoxTargetedByOthers(c.box, allRobots)) {
-            bool available = checkBoxAvailability(c.box, allRobots);
-            if (available) {
-                std::cout << "Nearest available box confirmed free by ACL: " << c.box->x << "," << c.box->y << std::endl;
-                return c.box;
-            } else {
-                std::cout << "Box " << c.box->x << "," << c.box->y << " is NOT available according to ACL responses." << std::endl;
-            }
-        } else {
-            std::cout << "Box " << c.box->x << "," << c.box->y << " is already targeted by another robot." << std::endl;
+bool Robot::windowRunningDry() const {
+    long long remaining = windowTick + static_cast<long long>(windowSteps.size()) - context.getTick();
+    return windowFinal ? remaining <= 0 : remaining <= context.getCooperative()->window() / 2;
+}
+
+bool Robot::routeDue(const Pos& target) const {
+    if (context.getCooperative())
+        return currentTarget != target || windowRunningDry();
+    return currentTarget != target || currentPath.empty() ||
+           (incremental && incremental->hasPendingChanges());
+}
+
+void Robot::prepare(const Grid& grid) {
+    hasPreparedRoute = false;
+    hasSensedBoxes = false;
+
+    Pos target;
+    if (upcomingGoal(grid, target)) {
+        if (!followsField() && routeDue(target)) {
+            computeRoute(grid, target, preparedPath);
+            preparedFrom = {x, y};
+            preparedTarget = target;
+            hasPreparedRoute = true;
         }
+    } else if (state == MOVING_TO_BOX && context.getConfig().assign == AssignMode::NEGOTIATE) {
+        // Claims and refusals change while robots act, so only the static
+        // filters apply here; findNearestNonPivotBox checks the rest
+        BoxFilter filter;
+        filter.maxStack = Box::targetLimit(context.getMemory().pivotExists());
+        filter.skipPivots = true;
+        grid.boxIndex().nearest(x, y, SENSED_BOXES, filter, sensedBoxes);
+        sensedFrom = {x, y};
+        hasSensedBoxes = true;
     }
-
-    std::cout << "No available boxes found." << std::endl;
-    return nullptr;
 }
 
-bool Robot::go_to(const Grid& grid, const sf::Vector2f& target, std::function<bool(Robot*)> onReached) {
-    int tx = static_cast<int>(target.x);
-    int ty = static_cast<int>(target.y);
+bool Robot::go_to(const Grid& grid, const Pos& target, std::function<bool(Robot*)> onReached) {
+    if (context.getCooperative())
+        return goCooperative(grid, target, onReached);
+    if (followsField())
+        return followField(grid, target, onReached);
 
-    if (currentTarget != std::make_pair(tx, ty) || currentPath.empty()) {
-        // Compute new path using Dijkstra and store in currentPath
-        std::cout << "About to compute" << std::endl;
-        currentPath = computeDijkstraPath(grid, x, y, tx, ty);
-        std::cout << "Robot " << name << " computed new path to (" << currentPath.front().first << "," << currentPath.front().second << ")\n";
-        currentTarget = {tx, ty};
+    int tx = target.first;
+    int ty = target.second;
 
+    // A route prepared in the plan phase also covers repairs of the incremental
+    // planner; cells changed while robots act are picked up next tick
+    if (currentTarget != std::make_pair(tx, ty) || currentPath.empty() || preparedRouteFor(target)) {
+        // Compute new path with the configured planner and store in currentPath
+        planRoute(grid, target);
 
         if (currentPath.empty()) {
             // No path found
+            idleCause = IdleCause::NO_ROUTE;
             return false;
         }
+
+        WLOG_DEBUG(PLANNER, "robot #{} computed a {}-step path to ({},{})", id, currentPath.size(), tx, ty);
     }
 
     // Check if robot is adjacent or on the target
@@ -143,87 +255,392 @@ bool Robot::go_to(const Grid& grid, const sf::Vector2f& target, std::function<bo
     y = nextStep.second;
 
     if(x != storedX || y != storedY) {
-        SharedMemory::get().addMovements(1);
+        context.getMemory().addMovements(1);
     }
 
     return false;
 }
 
-bool Robot::tryPickup(Grid& grid) {
-    std::cout << "Trying to pick up box..." << std::endl;
-    if (carrying) return false;
+bool Robot::followsField() const {
+    return state == MOVING_TO_PIVOT && context.getConfig().flowField;
+}
 
-    if (!SharedMemory::get().pivotExists()) {
-        // No pivot yet - first box becomes pivot
-        const int dirs[4][2] = {
-            { 1, 0}, {-1, 0},
-            { 0, 1}, { 0,-1}
-        };
+bool Robot::followField(const Grid& grid, const Pos& target, std::function<bool(Robot*)> onReached) {
+    int dist = abs(x - target.first) + abs(y - target.second);
+    if (dist <= 1) {
+        if (onReached)
+            return onReached(this);
+        return true;
+    }
+
+    FlowField& field = context.getFlowFields().toward(grid.index(target.first, target.second));
+    int next = field.nextStep(grid.index(x, y));
+    if (next < 0) {
+        idleCause = IdleCause::NO_ROUTE;
+        return false;
+    }
+
+    x = grid.xOf(next);
+    y = grid.yOf(next);
+    context.getMemory().addMovements(1);
+    return false;
+}
 
-        for (auto& d : dirs) {
-            int nx = x + d[0];
-            int ny = y + d[1];
+bool Robot::goCooperative(const Grid& grid, const Pos& target, std::function<bool(Robot*)> onReached) {
+    int dist = abs(x - target.first) + abs(y - target.second);
+    if (dist <= 1 && holdPosition(grid)) {
+        if (onReached)
+            return onReached(this);
+        return true;
+    }
 
-            if (!inBounds(grid, nx, ny)) continue;
+    // Re-plan halfway through the window so the reservations never run dry,
+    // unless the window already ends beside the target
+    if (currentTarget != target || windowRunningDry())
+        replanWindow(grid, target);
 
-            Box* box = grid.cells[ny][nx].box;
-            if (!box) continue;
+    followWindow();
+    return false;
+}
 
-            // Cannot pick up stacked boxes
-            if (box->stackSize > 1)
-                return false;
+void Robot::replanWindow(const Grid& grid, const Pos& target) {
+    CooperativePlanner& coop = *context.getCooperative();
+    long long now = context.getTick();
+
+    // The route ignores other robots; the window only has to reach a point on
+    // it, or any side of the target once that is within reach
+    planRoute(grid, target);
+    stranded = currentPath.empty();
+    Pos waypoint = target;
+    int radius = 1;
+    if (currentPath.size() > static_cast<size_t>(coop.window()) + 1) {
+        waypoint = currentPath[coop.window() - 1];
+        radius = 0;
+    }
 
-            SharedMemory::get().addMovements(1);
+    coop.table().release(this);
+    SearchStats stats;
+    WindowOutcome outcome = coop.plan(grid, this, {x, y}, now, waypoint, radius, windowSteps, &stats);
+    countSearch(Counter::WINDOW_SEARCHES, stats);
+    windowFinal = radius == 1 && outcome == WindowOutcome::REACHED;
+    windowStart = {x, y};
+    windowTick = now;
+    coop.commit(grid, this, windowStart, windowTick, windowSteps);
+
+    if (outcome != WindowOutcome::REACHED) {
+        WLOG_DEBUG(PLANNER, "robot #{} could not reach its waypoint this window", id);
+        askParkedToYield(grid, waypoint, radius);
+    }
+}
 
-            std::cout << "Box set as pivot" << std::endl;
-            box->isPivot = true;
-            targetBox = nullptr; 
-            SharedMemory::get().setPivot(box);
-            state = MOVING_TO_BOX;
-            return true;
+int Robot::yieldRank() const {
+    switch (state) {
+        case MOVING_TO_PIVOT: return 2;
+        case MOVING_TO_BOX: return stranded ? 0 : 1;
+        default: return 0;
+    }
+}
+
+void Robot::askParkedToYield(const Grid& grid, const Pos& waypoint, int radius) {
+    ReservationTable& table = context.getCooperative()->table();
+    int window = context.getCooperative()->window();
+    long long now = context.getTick();
+    int here = grid.index(x, y);
+    int rank = yieldRank();
+
+    // Cheapest way to the waypoint within one window. A robot parked on the
+    // way that can be asked to move costs PUSH_COST extra moves, so the way
+    // only goes through it when there is no free one round; any other parked
+    // robot is a wall.
+    using Entry = std::pair<int, int>;     // (cost, cell)
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    std::unordered_map<int, Entry> best = {{here, {0, here}}};     // cell -> (cost, from)
+    open.push({0, here});
+    int end = -1;
+    while (!open.empty()) {
+        auto [cost, idx] = open.top();
+        open.pop();
+        if (cost > best[idx].first) continue;
+        if (abs(grid.xOf(idx) - waypoint.first) + abs(grid.yOf(idx) - waypoint.second) <= radius) {
+            end = idx;
+            break;
         }
+
+        for (int i = 0; i < 4; i++) {
+            int next = idx + grid.neighborOffsets()[i];
+            if (grid.isBlocked(next) || abs(grid.xOf(next) - x) + abs(grid.yOf(next) - y) > window)
+                continue;
+            int step = 1;
+            const Robot* parked = table.parkedOn(next, now);
+            if (parked && parked != this) {
+                if (parked->yieldRank() >= rank || table.boxedIn(parked, now)) continue;
+                step += PUSH_COST;
+            }
+            auto it = best.find(next);
+            if (it != best.end() && it->second.first <= cost + step) continue;
+            best[next] = {cost + step, idx};
+            open.push({cost + step, next});
+        }
+    }
+    if (end < 0) return;
+
+    std::vector<int> way;
+    for (int idx = end; idx != here; idx = best[idx].second)
+        way.push_back(idx);
+    way.push_back(here);
+    std::reverse(way.begin(), way.end());
+
+    ReservationTable::YieldRequest ask;
+    ask.priority = rank;
+    ask.cells = way;
+    askAlong(way, ask);
+}
+
+void Robot::askAlong(const std::vector<int>& way, ReservationTable::YieldRequest ask) {
+    ReservationTable& table = context.getCooperative()->table();
+    long long now = context.getTick();
+
+    ask.chain.push_back(this);
+    for (int idx : way) {
+        const Robot* parked = table.parkedOn(idx, now);
+        if (parked && parked->yieldRank() < ask.priority &&
+            std::find(ask.chain.begin(), ask.chain.end(), parked) == ask.chain.end())
+            table.askToYield(parked, ask);
+    }
+}
+
+bool Robot::makeWay(const Grid& grid) {
+    ReservationTable::YieldRequest request;
+    if (!context.getCooperative()->table().takeYieldRequest(this, request))
+        return false;
+
+    // Stale if the robot has moved on since it was asked
+    if (!contains(request.cells, grid.index(x, y)))
         return false;
+
+    auto clear = [&](int idx) { return !contains(request.cells, idx); };
+    if (moveToNearest(grid, [&](int idx) { return clear(idx) && !besideBox(grid, idx); }, &request) ||
+        moveToNearest(grid, clear, &request))
+        return true;
+
+    // Boxed in. If the asker stands right beside, this is the pocket it
+    // came to and it is in the mouth: it steps back first, one rank up so
+    // even a carrier does.
+    ReservationTable& table = context.getCooperative()->table();
+    table.markBoxedIn(this, context.getTick());
+    const Robot* asker = request.chain.empty() ? nullptr : request.chain.back();
+    if (asker && abs(asker->x - x) + abs(asker->y - y) == 1) {
+        ReservationTable::YieldRequest back;
+        back.priority = request.priority + 1;
+        back.cells = {grid.index(asker->x, asker->y)};
+        back.chain = {this};
+        table.askToYield(asker, back);
     }
-    
-    // There's already a pivot
-    Box* pivot = SharedMemory::get().getPivot();
-    if (!pivot) return false;
+    return false;
+}
 
-    int boxesHeadingToPivot = SharedMemory::get().countBoxesGoingToPivot(grid.getRobots());
+bool Robot::holdPosition(const Grid& grid) {
+    CooperativePlanner& coop = *context.getCooperative();
+    long long now = context.getTick();
 
-    const int dirs[4][2] = {
-        { 1, 0}, {-1, 0},
-        { 0, 1}, { 0,-1}
-    };
+    // Window used up: we are already parked here
+    if (windowTick + static_cast<long long>(windowSteps.size()) <= now)
+        return true;
+
+    // Stopping early is only safe if nobody planned to pass through here later
+    ReservationTable& table = coop.table();
+    table.release(this);
+    if (table.canPark(grid.index(x, y), now, this)) {
+        windowSteps.clear();
+        windowStart = {x, y};
+        windowTick = now;
+        coop.commit(grid, this, windowStart, windowTick, windowSteps);
+        return true;
+    }
+
+    coop.commit(grid, this, windowStart, windowTick, windowSteps);
+    return false;
+}
+
+void Robot::stepAside(const Grid& grid) {
+    long long now = context.getTick();
 
-    for (auto& d : dirs) {
-        int nx = x + d[0];
-        int ny = y + d[1];
+    // Still travelling, or parked where nobody needs to reach
+    int here = grid.index(x, y);
+    if (windowTick + static_cast<long long>(windowSteps.size()) > now || !besideBox(grid, here))
+        return;
+
+    moveToNearest(grid, [&](int idx) { return !besideBox(grid, idx); }, nullptr);
+}
 
-        if (!inBounds(grid, nx, ny)) continue;
+bool Robot::moveToNearest(const Grid& grid, const std::function<bool(int)>& fits,
+                          const ReservationTable::YieldRequest* request) {
+    CooperativePlanner& coop = *context.getCooperative();
+    long long now = context.getTick();
+    int here = grid.index(x, y);
+
+    // Nearest free cell that fits, within one window; a robot making way
+    // never crosses the robots that asked it
+    std::vector<int> chain;
+    if (request)
+        for (const Robot* robot : request->chain)
+            chain.push_back(grid.index(robot->x, robot->y));
+    std::deque<std::pair<int, int>> frontier = {{here, 0}};
+    std::unordered_map<int, int> cameFrom = {{here, here}};
+    int rest = -1;
+    while (!frontier.empty() && rest < 0) {
+        auto [idx, d] = frontier.front();
+        frontier.pop_front();
+        if (d >= coop.window()) continue;
+
+        for (int i = 0; i < 4; i++) {
+            int next = idx + grid.neighborOffsets()[i];
+            if (grid.isBlocked(next) || cameFrom.count(next)) continue;
+            if (contains(chain, next)) continue;
+            cameFrom[next] = idx;
+            if (fits(next) && coop.table().canPark(next, now + d + 1, this)) {
+                rest = next;
+                break;
+            }
+            frontier.push_back({next, d + 1});
+        }
+    }
+    if (rest < 0) return false;
+
+    Pos restPos = {grid.xOf(rest), grid.yOf(rest)};
+    coop.table().release(this);
+    SearchStats stats;
+    WindowOutcome outcome = coop.plan(grid, this, {x, y}, now, restPos, 0, windowSteps, &stats);
+    countSearch(Counter::WINDOW_SEARCHES, stats);
+    windowStart = {x, y};
+    windowTick = now;
+    currentTarget = restPos;
+    coop.commit(grid, this, windowStart, windowTick, windowSteps);
+
+    // Blocked: pass the request on to the robots parked along the way out,
+    // one rank up, since the way out of a pocket is often held by robots of
+    // the asker's own rank. Robots already in the chain are neither crossed
+    // nor asked, so it can never lead back to one of them.
+    if (request && outcome != WindowOutcome::REACHED) {
+        std::vector<int> way = {here};
+        for (int idx = rest; idx != here; idx = cameFrom[idx])
+            way.push_back(idx);
+        std::reverse(way.begin() + 1, way.end());
+
+        ReservationTable::YieldRequest ask = *request;
+        ask.priority++;
+        ask.cells.insert(ask.cells.end(), way.begin(), way.end());
+        askAlong(way, ask);
+    }
+    return true;
+}
 
-        Box* box = grid.cells[ny][nx].box;
-        if (!box) continue;
+void Robot::followWindow() {
+    long long now = context.getTick();
+    lastStepTick = now;
+
+    long long i = now - windowTick;
+    if (i < 0 || i >= static_cast<long long>(windowSteps.size()))
+        return;
+
+    Pos next = windowSteps[i];
+    if (next == Pos(x, y)) {
+        context.getMemory().addWaits(1);
+        if (idleCause == IdleCause::OTHER)
+            idleCause = IdleCause::RESERVATION;
+        return;
+    }
+
+    x = next.first;
+    y = next.second;
+    context.getMemory().addMovements(1);
+}
+
+void Robot::setState(RobotState next) {
+    if (next == state) return;
+    SharedMemory& memory = context.getMemory();
+    int slot = memory.findPivot(targetPivot);
+    if (slot >= 0 && state == MOVING_TO_PIVOT)
+        memory.addBoxesGoingToPivot(slot, -1);
+    else if (slot >= 0 && next == MOVING_TO_PIVOT)
+        memory.addBoxesGoingToPivot(slot, 1);
+    state = next;
+}
+
+const Box* Robot::reservedPivot(const Grid& grid) const {
+    return context.getMemory().findPivot(targetPivot) >= 0 ? grid.box(targetPivot) : nullptr;
+}
 
-        if (box->stackSize > 1)
+bool Robot::promoteTarget(Grid& grid, int slot) {
+    context.getMemory().addMovements(1);
+    context.getPivots().open(grid, targetBox, slot);
+    targetBox = BoxHandle();
+    worked = true;
+    setState(MOVING_TO_BOX);
+    return true;
+}
+
+bool Robot::tryPickup(Grid& grid) {
+    WLOG_TRACE(ROBOT, "robot #{} trying to pick up a box", id);
+    if (carrying) return false;
+
+    SharedMemory& memory = context.getMemory();
+    if (!memory.pivotExists()) {
+        // No pivot yet - first box becomes pivot
+        int here = grid.index(x, y);
+
+        for (int i = 0; i < 4; i++) {
+            BoxHandle handle = grid.boxAt(here + grid.neighborOffsets()[i]);
+            if (!handle || handle != targetBox) continue;
+            return promoteTarget(grid, memory.freePivotSlot());
+        }
+        return false;
+    }
+    
+    // There's already a pivot
+    int here = grid.index(x, y);
+
+    for (int i = 0; i < 4; i++) {
+        BoxHandle handle = grid.boxAt(here + grid.neighborOffsets()[i]);
+        if (!handle || handle != targetBox) continue;
+        const Box* box = grid.box(handle);
+
+        // Never carry the pivot itself away
+        if (box->isPivot) continue;
+
+        // A stack from the layout, targeted before the pivot was chosen: it
+        // cannot be carried, so let it go
+        if (box->stackSize > 1) {
+            targetBox = BoxHandle();
             return false;
+        }
 
-        std::cout << "Boxes heding to pivot: " << boxesHeadingToPivot << std::endl;
+        // If every pivot is full or will be once the boxes heading there
+        // arrive, start another one here if a slot is free and the box has
+        // room around it, or wait near the box
+        int slot = context.getPivots().bestPivotFor(grid, here);
+        if (slot < 0) {
+            int free = memory.freePivotSlot();
+            if (free >= 0 && context.getPivots().mayOpen(grid, handle, this))
+                return promoteTarget(grid, free);
 
-        // If picking this box would exceed pivot limit, wait near box (do not pick)
-        if (boxesHeadingToPivot + pivot->stackSize >= 5) {
             // Stay nearby, do not pick
-            std::cout << "Pivot full or nearly full, waiting near box at (" << box->x << "," << box->y << ")" << std::endl;
+            WLOG_DEBUG(ROBOT, "pivot full or nearly full, robot #{} waiting near box ({},{})", id, box->x, box->y);
+            idleCause = IdleCause::PIVOT_FULL;
             return false;
         }
+        WLOG_TRACE(ROBOT, "boxes heading to pivot: {}", memory.boxesGoingToPivot(slot));
 
-        // Otherwise pick up and move to pivot
-        carriedBox = box;
+        // Otherwise pick up and move to pivot, holding a place on its stack
+        if (TraceRecorder* trace = context.getTrace())
+            trace->pick(id, box->x, box->y);
+        carriedBox = grid.takeBox(box->x, box->y);
         carrying = true;
-        grid.cells[ny][nx].box = nullptr;
-        grid.cells[ny][nx].type = EMPTY;
-        state = MOVING_TO_PIVOT;
-        SharedMemory::get().addMovements(1);
+        targetPivot = memory.getPivot(slot);
+        setState(MOVING_TO_PIVOT);
+        context.getMemory().addMovements(1);
+        context.getMetrics().add(Counter::PICKS);
+        worked = true;
         return true;
     }
 
@@ -233,41 +650,43 @@ bool Robot::tryPickup(Grid& grid) {
 bool Robot::tryStack(Grid& grid) {
     if (!carrying) return false;
 
-    const int dirs[4][2] = {
-        { 1, 0}, {-1, 0},
-        { 0, 1}, { 0,-1}
-    };
-
-    for (auto& d : dirs) {
-        int nx = x + d[0];
-        int ny = y + d[1];
-
-        if (!inBounds(grid, nx, ny)) continue;
+    int here = grid.index(x, y);
 
-        Box* target = grid.cells[ny][nx].box;
-        if (!target) continue;
+    for (int i = 0; i < 4; i++) {
+        // Only ever stack onto the pivot, not whatever box happens to be adjacent
+        int at = here + grid.neighborOffsets()[i];
+        BoxHandle handle = grid.boxAt(at);
+        if (!handle || handle != targetPivot) continue;
 
-        // Merge stacks
-        target->merge(*carriedBox);
-        SharedMemory::get().addMovements(1);
+        // Merge stacks (the grid destroys the carried box, which can move the
+        // pivot within the store, so it is looked up afterwards)
+        grid.stackBox(grid.xOf(at), grid.yOf(at), carriedBox);
+        context.getMemory().addMovements(1);
+        context.getMetrics().add(Counter::STACKS);
+        worked = true;
+        Box* target = grid.box(handle);
+        if (TraceRecorder* trace = context.getTrace())
+            trace->stack(id, target->x, target->y, target->stackSize);
 
         // After merging, check if stack size reached limit
-        if (target->stackSize >= 5) {
-            std::cout << "Pivot box at " << target->x << "," << target->y << " reached max stack size. Unmarking pivot.\n";
+        if (target->stackSize >= Box::MAX_STACK) {
+            WLOG_INFO(ROBOT, "pivot box ({},{}) reached max stack size, unmarking pivot", target->x, target->y);
             target->isPivot = false;
+            if (TraceRecorder* trace = context.getTrace())
+                trace->pivot(target->x, target->y, false);
 
             // If this pivot is stored in SharedMemory, clear it
-            if (SharedMemory::get().pivotExists() && SharedMemory::get().getPivot() == target) {
-                SharedMemory::get().clearPivot();
-            }
+            int slot = context.getMemory().findPivot(handle);
+            if (slot >= 0)
+                context.getMemory().clearPivot(slot);
         }
 
-        delete carriedBox;
-        carriedBox = nullptr;
+        carriedBox = BoxHandle();
         carrying = false;
 
-        state = MOVING_TO_BOX;
-        targetBox = nullptr;
+        setState(MOVING_TO_BOX);
+        targetBox = BoxHandle();
+        targetPivot = BoxHandle();
 
         return true;
     }
@@ -276,39 +695,84 @@ bool Robot::tryStack(Grid& grid) {
 }
 
 void Robot::update(Grid& grid) {
+    Pos before = {x, y};
+    idleCause = IdleCause::OTHER;
+    worked = false;
+
+    // A robot asked to make way moves off first and decides again next tick
+    if (!(context.getCooperative() && makeWay(grid)))
+        decide(grid);
+
+    // Reserved slots are a promise to the other robots: keep to them even on
+    // ticks where the robot is busy negotiating instead of travelling
+    if (context.getCooperative() && lastStepTick != context.getTick())
+        followWindow();
+
+    if (Pos(x, y) == before && !worked)
+        context.getMetrics().idle(id, state == EXPLORING ? IdleCause::NO_BOX : idleCause);
+}
 
+void Robot::decide(Grid& grid) {
     if (state == MOVING_TO_BOX) {
-        if(targetBox){
+        if (const Box* box = grid.box(targetBox)) {
             go_to(
                 grid,
-                sf::Vector2f(targetBox->x, targetBox->y),
+                Pos(box->x, box->y),
                 [&](Robot* r) {
                     return r->tryPickup(grid);
                 }
             );
-        } else{
-            targetBox = findNearestNonPivotBox(grid, grid.getRobots());
+        } else if (candidateBox) {
+            // The box may have been claimed and moved since the query went out
+            if (grid.boxAt(candidatePos.first, candidatePos.second) != candidateBox) {
+                negotiations.cancel(queryConvId);
+                queryConvId = 0;
+                candidateBox = BoxHandle();
+                return;
+            }
+
+            // Settles the claim once every peer answered or the deadline passed
+            negotiations.update(context.getTick());
+            if (!candidateBox)
+                return;
 
-            if (targetBox == nullptr){ 
-                std::cout << "No non-pivot boxes left.\n";
-                state = EXPLORING;
+            // Keep heading for the candidate while the peers answer
+            go_to(grid, candidatePos, nullptr);
+        } else if (context.getConfig().assign != AssignMode::NEGOTIATE) {
+            // The allocation stage ran at the start of this tick and had no box left for us
+            WLOG_DEBUG(ROBOT, "robot #{}: no box left to assign", id);
+            setState(EXPLORING);
+            return;
+        } else {
+            BoxHandle box = findNearestNonPivotBox(grid, grid.getRobots());
+
+            if (box) {
+                startAvailabilityQuery(grid, box);
+            } else if (!rejectedBoxes.empty()) {
+                // Every box was refused this round; ask again from the nearest one
+                rejectedBoxes.clear();
+            } else {
+                WLOG_DEBUG(ROBOT, "robot #{}: no non-pivot boxes left", id);
+                setState(EXPLORING);
                 return;
             }
         }
     } else if(state == MOVING_TO_PIVOT) {
-        Box* pivotBox = SharedMemory::get().pivotExists() ? SharedMemory::get().getPivot() : nullptr;
+        const Box* pivotBox = reservedPivot(grid);
         if (pivotBox) {
             go_to(
                 grid,
-                sf::Vector2f(pivotBox->x, pivotBox->y),
+                Pos(pivotBox->x, pivotBox->y),
                 [&](Robot* r) {
                     return r->tryStack(grid);
                 }
             );
         } else {
-            std::cout << "Pivot box no longer exists!\n";
-            state = EXPLORING;
+            WLOG_DEBUG(ROBOT, "robot #{}: pivot box no longer exists", id);
+            setState(EXPLORING);
         }    
+    } else if (state == EXPLORING && context.getCooperative()) {
+        stepAside(grid);
     }
 }
 
@@ -316,55 +780,45 @@ void Robot::update(Grid& grid) {
 ///ACL STUFF
 
 void Robot::receive(const acl::ACLMessage& msg) {
-    std::cout << "Robot " << name << " received message from " << msg.sender
-              << ": " << msg.content << std::endl;
+    WLOG_TRACE(ACL, "robot #{} received {} from #{} (conversation {})",
+               id, acl::performativeName(msg.performative), msg.sender, msg.conversationId);
 
-    if (msg.performative == acl::Performative::REQUEST) {
-        if (msg.content.find("available? box") != std::string::npos) {
-            // Parse
-            int bx, by;
-            sscanf(msg.content.c_str(), "available? box(%d,%d)", &bx, &by);
+    if (msg.performative == acl::Performative::CFP) {
+        if (const acl::BoxQuery* query = std::get_if<acl::BoxQuery>(&msg.content)) {
+            int bx = query->x;
+            int by = query->y;
 
             bool isAvailable = true;
 
-            if (carrying && carriedBox && carriedBox->x == bx && carriedBox->y == by)
+            const Grid& grid = context.getGrid();
+            const Box* carried = grid.box(carriedBox);
+            if (carrying && carried && carried->x == bx && carried->y == by)
                 isAvailable = false;
 
-            if (targetBox && targetBox->x == bx && targetBox->y == by)
+            const Box* target = grid.box(targetBox);
+            if (target && target->x == bx && target->y == by)
                 isAvailable = false;
 
-            std::string replyContent = isAvailable ? "YES" : "NO";
-
-            acl::ACLMessage reply(
-                acl::Performative::INFORM,
-                name,
-                msg.sender,
-                replyContent,
-                "SL",
-                "warehouse-ontology",
-                "fipa-contract-net",
-                msg.conversationId
-            );
+            // Both of us are asking about the same box: the smaller name keeps it
+            if (candidateBox && candidatePos == Pos(bx, by) &&
+                name < context.getRegistry().getAgent(msg.sender)->getName())
+                isAvailable = false;
 
-            send(msg.sender, reply);
+            if (isAvailable)
+                negotiations.propose(msg, acl::Availability{true});
+            else
+                negotiations.refuse(msg);
         }
         else {
-            std::cout << "Unknown request content: " << msg.content << std::endl;
+            WLOG_WARN(ACL, "robot #{}: unknown CFP content from #{}", id, msg.sender);
         }
     }
-    else if (msg.performative == acl::Performative::INFORM) {
+    else if (msg.performative == acl::Performative::PROPOSE || msg.performative == acl::Performative::REFUSE) {
         handleResponse(msg);
     }
 }
 
 void Robot::handleResponse(const acl::ACLMessage& msg) {
-    auto it = pendingRequests.find(msg.conversationId);
-    if (it != pendingRequests.end()) {
-        it->second = true;
-        std::cout << "Response received for conversation: " << msg.conversationId << std::endl;
-
-        if (waitingForResponses.find(msg.conversationId) != waitingForResponses.end()) {
-            waitingForResponses[msg.conversationId]--;
-        }
-    }
-}
\ No newline at end of file
+    if (negotiations.handleReply(msg))
+        WLOG_TRACE(ACL, "robot #{} response recorded for conversation {}", id, msg.conversationId);
+}
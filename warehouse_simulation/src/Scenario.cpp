@@ -0,0 +1,218 @@
+#include "Scenario.hpp"
+#include "SharedMemory.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+namespace {
+
+bool parseLong(const char* text, long long& out) {
+    if (!text || !*text) return false;
+    char* end = nullptr;
+    out = std::strtoll(text, &end, 10);
+    return *end == '\0';
+}
+
+bool parseWall(const char* text, WallRange& wall) {
+    return text && std::sscanf(text, "%d,%d,%d,%d",
+                               &wall.startX, &wall.startY, &wall.endX, &wall.endY) == 4;
+}
+
+} // namespace
+
+void printScenarioUsage(std::ostream& out, const char* program) {
+    out << "Usage: " << program << " [options]\n"
+        << "  --rows N            grid rows (default 30)\n"
+        << "  --cols N            grid columns (default 30)\n"
+        << "  --robots N          number of robots (default 5)\n"
+        << "  --boxes N           number of boxes (default 17)\n"
+        << "  --wall X0,Y0,X1,Y1  add a wall rectangle; the first one replaces the default layout\n"
+        << "  --no-walls          start from an empty layout\n"
+        << "  --layout FILE       load the floor plan from a text or binary layout file\n"
+        << "  --seed N            RNG seed (default: random)\n"
+        << "  --planner NAME      path planner: dijkstra, astar, jps or hpa (default astar)\n"
+        << "  --replan MODE       target (plan once per target) or incremental (D* Lite)\n"
+        << "  --assign MODE       negotiate (per-robot ACL, default), auto, hungarian or auction\n"
+        << "  --cooperative       plan collision-free paths through a shared reservation table\n"
+        << "  --window N          cooperative look-ahead in moves (default 16)\n"
+        << "  --flow-field        carry boxes along one shared distance field to the pivot\n"
+        << "  --pivots N          stacking sites open at once, 1 to 8 (default 1)\n"
+        << "  --tick-threads N    threads for each tick's plan phase (default 1, 0 = one per core)\n"
+        << "  --max-ticks N       stop after N ticks (default: no limit)\n"
+        << "  --verbose           keep the per-robot log output\n"
+        << "  --metrics FILE      headless: write subsystem metrics to FILE as JSON lines\n"
+        << "  --metrics-every N   with --metrics, also write them every N ticks\n"
+        << "  --trace FILE        headless: record a replayable event trace to FILE\n"
+        << "  --trace-keyframes N with --trace, store the full state every N ticks (default 256)\n"
+        << "  --offscreen FILE    windowed binary: render offscreen, save the last frame to FILE\n"
+        << "  --tick-rate N       windowed binary: ticks per second (default 20, 0 = as fast as possible)\n";
+}
+
+bool parseScenarioArgs(int argc, char** argv, ScenarioConfig& config, std::string& error) {
+    bool customWalls = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        long long number = 0;
+
+        if (arg == "--verbose") {
+            config.verbose = true;
+            continue;
+        }
+        if (arg == "--cooperative") {
+            config.cooperative = true;
+            continue;
+        }
+        if (arg == "--flow-field") {
+            config.flowField = true;
+            continue;
+        }
+        if (arg == "--no-walls") {
+            config.walls.clear();
+            customWalls = true;
+            continue;
+        }
+        if (arg == "--planner") {
+            if (!value || !parsePlannerKind(value, config.planner)) {
+                error = "--planner expects dijkstra, astar, jps or hpa";
+                return false;
+            }
+            i++;
+            continue;
+        }
+        if (arg == "--assign") {
+            if (!value || !parseAssignMode(value, config.assign)) {
+                error = "--assign expects negotiate, auto, hungarian or auction";
+                return false;
+            }
+            i++;
+            continue;
+        }
+        if (arg == "--replan") {
+            std::string mode = value ? value : "";
+            if (mode == "target") config.replan = ReplanMode::ON_TARGET;
+            else if (mode == "incremental") config.replan = ReplanMode::INCREMENTAL;
+            else {
+                error = "--replan expects target or incremental";
+                return false;
+            }
+            i++;
+            continue;
+        }
+        if (arg == "--metrics") {
+            if (!value) {
+                error = "--metrics expects a file name";
+                return false;
+            }
+            config.metricsPath = value;
+            i++;
+            continue;
+        }
+        if (arg == "--trace") {
+            if (!value) {
+                error = "--trace expects a file name";
+                return false;
+            }
+            config.tracePath = value;
+            i++;
+            continue;
+        }
+        if (arg == "--offscreen") {
+            if (!value) {
+                error = "--offscreen expects a file name";
+                return false;
+            }
+            config.offscreenPath = value;
+            i++;
+            continue;
+        }
+        if (arg == "--layout") {
+            if (!value) {
+                error = "--layout expects a file name";
+                return false;
+            }
+            config.layoutPath = value;
+            i++;
+            continue;
+        }
+        if (arg == "--wall") {
+            WallRange wall;
+            if (!parseWall(value, wall)) {
+                error = "--wall expects X0,Y0,X1,Y1";
+                return false;
+            }
+            if (!customWalls) config.walls.clear();
+            customWalls = true;
+            config.walls.push_back(wall);
+            i++;
+            continue;
+        }
+
+        if (arg != "--rows" && arg != "--cols" && arg != "--robots" && arg != "--boxes" &&
+            arg != "--seed" && arg != "--max-ticks" && arg != "--window" && arg != "--pivots" &&
+            arg != "--tick-threads" && arg != "--metrics-every" &&
+            arg != "--trace-keyframes" && arg != "--tick-rate") {
+            error = "unknown option " + arg;
+            return false;
+        }
+        if (!parseLong(value, number) || number < 0) {
+            error = arg + " expects a non-negative integer";
+            return false;
+        }
+        i++;
+
+        if (arg == "--rows") config.rows = static_cast<int>(number);
+        else if (arg == "--cols") config.cols = static_cast<int>(number);
+        else if (arg == "--robots") config.robotCount = static_cast<int>(number);
+        else if (arg == "--boxes") config.boxCount = static_cast<int>(number);
+        else if (arg == "--max-ticks") config.maxTicks = number;
+        else if (arg == "--window") config.window = static_cast<int>(number);
+        else if (arg == "--pivots") config.pivots = static_cast<int>(number);
+        else if (arg == "--tick-threads") config.tickThreads = static_cast<int>(number);
+        else if (arg == "--metrics-every") config.metricsEvery = number;
+        else if (arg == "--trace-keyframes") config.traceKeyframes = number;
+        else if (arg == "--tick-rate") config.tickRate = static_cast<int>(number);
+        else {
+            config.seed = static_cast<unsigned int>(number);
+            config.seedGiven = true;
+        }
+    }
+
+    if (config.window < 1) {
+        error = "--window must be at least 1";
+        return false;
+    }
+    if (config.pivots < 1 || config.pivots > SharedMemory::MAX_PIVOTS) {
+        error = "--pivots must be between 1 and " + std::to_string(SharedMemory::MAX_PIVOTS);
+        return false;
+    }
+    if (config.traceKeyframes < 1) {
+        error = "--trace-keyframes must be at least 1";
+        return false;
+    }
+    if (config.flowField && config.cooperative) {
+        error = "--flow-field cannot be combined with --cooperative";
+        return false;
+    }
+    if (!config.layoutPath.empty()) {
+        config.layout = loadLayout(config.layoutPath, error);
+        if (!config.layout) return false;
+        config.rows = config.layout->rows;
+        config.cols = config.layout->cols;
+        if (config.layout->boxCount() > 0)
+            config.boxCount = static_cast<int>(config.layout->boxCount());
+    }
+    if (config.rows < 1 || config.cols < 1) {
+        error = "grid must have at least one row and one column";
+        return false;
+    }
+    if (!config.seedGiven) {
+        config.seed = std::random_device{}();
+        config.seedGiven = true;
+    }
+    return true;
+}
@@ -1,72 +1,82 @@
 #include "SharedMemory.hpp"
-#include "Robot.hpp"
 
-SharedMemory::SharedMemory()
-    : pivot(nullptr) 
-{}
+#include <algorithm>
 
-SharedMemory& SharedMemory::get() {
-    static SharedMemory instance;
-    return instance;
-}
+SharedMemory::SharedMemory(int pivots)
+    : slotCount(std::clamp(pivots, 1, MAX_PIVOTS)), tallies(new Tally[Metrics::SHARDS]) {}
 
-bool SharedMemory::pivotExists() const {
-    std::lock_guard<std::mutex> lock(mtx);
-    return pivot != nullptr;
+void SharedMemory::setPivot(int slot, BoxHandle value) {
+    uint64_t was = slots[slot].pivot.exchange(value.key(), std::memory_order_acq_rel);
+    if (was == 0 && value) openPivots.fetch_add(1, std::memory_order_release);
+    else if (was != 0 && !value) openPivots.fetch_sub(1, std::memory_order_release);
 }
 
-void SharedMemory::setPivot(Box* value) {
-    std::lock_guard<std::mutex> lock(mtx);
-    pivot = value;
+void SharedMemory::clearPivot(int slot) {
+    setPivot(slot, BoxHandle());
+    slots[slot].inbound.store(0, std::memory_order_relaxed);
 }
 
-Box* SharedMemory::getPivot() const {
-    std::lock_guard<std::mutex> lock(mtx);
-    return pivot;
+int SharedMemory::findPivot(BoxHandle handle) const {
+    if (!handle) return -1;
+    for (int i = 0; i < slotCount; i++)
+        if (slots[i].pivot.load(std::memory_order_acquire) == handle.key())
+            return i;
+    return -1;
 }
 
-void SharedMemory::clearPivot(){
-    pivot = nullptr;
+int SharedMemory::freePivotSlot() const {
+    for (int i = 0; i < slotCount; i++)
+        if (slots[i].pivot.load(std::memory_order_acquire) == 0)
+            return i;
+    return -1;
 }
 
-int SharedMemory::countBoxesGoingToPivot(const std::vector<Robot*>& robots) {
-    Box* pivot = getPivot();
-    if (!pivot) return 0;
-
-    int count = 0;
-
-    for (auto r : robots) {
-        if (r->state == MOVING_TO_PIVOT) {
-            count++;
-        }
-    }
-
-    return count;
+int SharedMemory::sum(std::atomic<int> Tally::*field) const {
+    int total = 0;
+    for (size_t i = 0; i < Metrics::SHARDS; i++)
+        total += (tallies[i].*field).load(std::memory_order_relaxed);
+    return total;
 }
 
 void SharedMemory::startTimer() {
-    std::lock_guard<std::mutex> lock(mtx);
     startTime = std::chrono::steady_clock::now();
-    totalMovements = 0;
+    for (size_t i = 0; i < Metrics::SHARDS; i++) {
+        tallies[i].movements.store(0, std::memory_order_relaxed);
+        tallies[i].waits.store(0, std::memory_order_relaxed);
+        tallies[i].conflicts.store(0, std::memory_order_relaxed);
+    }
 }
 
 long long SharedMemory::getElapsedTimeMs() const {
-    std::lock_guard<std::mutex> lock(mtx);
     auto now = std::chrono::steady_clock::now();
     return std::chrono::duration_cast<std::chrono::milliseconds>(now - startTime).count();
 }
 
 void SharedMemory::resetMovementCount() {
-    std::lock_guard<std::mutex> lock(mtx);
-    totalMovements = 0;
+    for (size_t i = 0; i < Metrics::SHARDS; i++)
+        tallies[i].movements.store(0, std::memory_order_relaxed);
 }
 
 void SharedMemory::addMovements(int count) {
-    std::lock_guard<std::mutex> lock(mtx);
-    totalMovements += count;
+    local().movements.fetch_add(count, std::memory_order_relaxed);
 }
 
 int SharedMemory::getMovementCount() const {
-    std::lock_guard<std::mutex> lock(mtx);
-    return totalMovements;
-}
\ No newline at end of file
+    return sum(&Tally::movements);
+}
+
+void SharedMemory::addWaits(int count) {
+    local().waits.fetch_add(count, std::memory_order_relaxed);
+}
+
+void SharedMemory::addConflicts(int count) {
+    local().conflicts.fetch_add(count, std::memory_order_relaxed);
+}
+
+int SharedMemory::getWaitCount() const {
+    return sum(&Tally::waits);
+}
+
+int SharedMemory::getConflictCount() const {
+    return sum(&Tally::conflicts);
+}
@@ -0,0 +1,248 @@
+#include "SimulationContext.hpp"
+#include "Log.hpp"
+
+#include <chrono>
+#include <ostream>
+#include <random>
+#include <set>
+#include <unordered_map>
+
+namespace {
+
+// Random empty cell that is not a wall, has no box and is not already taken
+Pos getRandomEmptyCell(const Grid& grid, const std::set<Pos>& occupied, std::mt19937& rng) {
+    std::uniform_int_distribution<int> distRow(0, grid.rows - 1);
+    std::uniform_int_distribution<int> distCol(0, grid.cols - 1);
+
+    while (true) {
+        int r = distRow(rng);
+        int c = distCol(rng);
+
+        if (!grid.isBlocked(grid.index(c, r)) && occupied.count({c, r}) == 0)
+            return {c, r};
+    }
+}
+
+} // namespace
+
+SimulationContext::SimulationContext(const ScenarioConfig& config)
+    : config(config), registry(&metrics), memory(config.pivots), pivots(*this), grid(config.rows, config.cols),
+      flowFields(grid, &metrics, static_cast<size_t>(config.pivots) + 1),
+      planner(makePlanner(config.planner)),
+      cooperative(config.cooperative ? std::make_unique<CooperativePlanner>(grid.cellCount(), config.window) : nullptr),
+      allocator(config.assign != AssignMode::NEGOTIATE ? std::make_unique<TaskAllocator>(config.assign) : nullptr),
+      pool(config.tickThreads != 1 ? std::make_unique<ThreadPool>(static_cast<unsigned>(config.tickThreads)) : nullptr) {}
+
+bool SimulationContext::populate(std::string& error) {
+    const Layout* layout = config.layout.get();
+
+    // Add walls first; a layout's wall layer is already in the grid's format
+    if (layout) {
+        if (!grid.loadWalls(layout->wallWords(), layout->wallWordCount())) {
+            error = config.layoutPath + ": wall layer does not match a " + std::to_string(grid.cols) + "x" +
+                    std::to_string(grid.rows) + " grid";
+            return false;
+        }
+    } else {
+        for (const WallRange& w : config.walls)
+            grid.addWallRange(w.startX, w.startY, w.endX, w.endY);
+    }
+
+    long long freeCells = static_cast<long long>(grid.rows) * grid.cols - grid.wallCount();
+    if (config.boxCount + config.robotCount > freeCells) {
+        error = "not enough free cells for " + std::to_string(config.boxCount) + " boxes and " +
+                std::to_string(config.robotCount) + " robots";
+        return false;
+    }
+
+    std::mt19937 rng(config.seed);
+    std::set<Pos> occupiedCells;    // robots only; boxes are in the grid
+
+    // Spawn boxes from the layout or at random empty cells; the store is
+    // sized up front so the run never allocates per box
+    grid.reserveBoxes(config.boxCount);
+    if (layout && layout->boxCount() > 0) {
+        for (size_t i = 0; i < layout->boxCount(); i++) {
+            const LayoutBox& b = layout->boxes()[i];
+            if (grid.isBlocked(grid.index(b.x, b.y))) {
+                error = config.layoutPath + ": box at (" + std::to_string(b.x) + "," + std::to_string(b.y) +
+                        ") is on a wall or another box";
+                return false;
+            }
+            grid.placeBox(b.x, b.y, b.height);
+        }
+    } else {
+        for (int i = 0; i < config.boxCount; i++) {
+            auto [bx, by] = getRandomEmptyCell(grid, occupiedCells, rng);
+            grid.placeBox(bx, by);
+        }
+    }
+
+    // Spawn robots at the layout's docks, then at random empty cells (no
+    // overlap with boxes or walls or other robots)
+    for (int i = 0; i < config.robotCount; i++) {
+        Pos spawn;
+        if (layout && static_cast<size_t>(i) < layout->dockCount()) {
+            const LayoutDock& d = layout->docks()[i];
+            spawn = {d.x, d.y};
+            if (grid.isBlocked(grid.index(d.x, d.y)) || occupiedCells.count(spawn)) {
+                error = config.layoutPath + ": dock at (" + std::to_string(d.x) + "," + std::to_string(d.y) +
+                        ") is blocked";
+                return false;
+            }
+        } else {
+            spawn = getRandomEmptyCell(grid, occupiedCells, rng);
+        }
+        auto [rx, ry] = spawn;
+        robots.push_back(std::make_unique<Robot>("Robot" + std::to_string(i + 1), rx, ry, *this));
+        occupiedCells.insert(spawn);
+        grid.addRobot(robots.back().get());
+    }
+
+    WLOG_INFO(SIM, "{}x{} grid, seed {}: {} robots, {} boxes", grid.cols, grid.rows, config.seed,
+              config.robotCount, config.boxCount);
+    memory.startTimer();
+    return true;
+}
+
+void SimulationContext::step() {
+    auto start = std::chrono::steady_clock::now();
+
+    // Delivery phase: messages sent during the previous tick arrive now
+    registry.deliverMessages();
+
+    // Allocation phase: pivots open where the remaining boxes call for them,
+    // then free robots get their next box in one global round
+    pivots.openPivots(grid);
+    if (allocator) {
+        std::vector<FlowField*> toPivots;
+        for (int slot = 0; slot < memory.pivotSlots(); slot++)
+            if (const Box* pivot = grid.box(memory.getPivot(slot)))
+                toPivots.push_back(&flowFields.toward(grid.index(pivot->x, pivot->y)));
+        allocator->allocate(grid, robots, toPivots);
+    }
+
+    // Plan phase: nothing mutates the grid, so the robots can search in parallel
+    if (pool)
+        pool->parallelFor(robots.size(), [this](size_t i) { robots[i]->prepare(grid); });
+    else
+        for (auto& r : robots)
+            r->prepare(grid);
+
+    // Act phase: decisions and grid mutations, committed in robot order
+    std::vector<int> before;
+    if (cooperative) {
+        before.reserve(robots.size());
+        for (const auto& r : robots)
+            before.push_back(grid.index(r->x, r->y));
+    }
+
+    for (auto& r : robots)
+        r->update(grid);
+
+    if (cooperative)
+        memory.addConflicts(countConflicts(before));
+    ticks++;
+    if (trace)
+        trace->endTick(*this);
+
+    long long done = metrics.total(Counter::PICKS) + metrics.total(Counter::STACKS) +
+                     metrics.total(Counter::PIVOTS);
+    if (done != progress) {
+        progress = done;
+        lastProgressTick = ticks;
+    }
+
+    metrics.record(Histogram::TICK_MICROS, std::chrono::duration_cast<std::chrono::microseconds>(
+                                               std::chrono::steady_clock::now() - start).count());
+}
+
+void SimulationContext::attachTrace(TraceRecorder* recorder) {
+    trace = recorder;
+    if (trace)
+        trace->begin(*this);
+}
+
+int SimulationContext::countConflicts(const std::vector<int>& before) const {
+    std::unordered_map<int, size_t> occupant;
+    int conflicts = 0;
+
+    for (size_t i = 0; i < robots.size(); i++) {
+        int here = grid.index(robots[i]->x, robots[i]->y);
+        auto [it, inserted] = occupant.emplace(here, i);
+        if (!inserted) {
+            conflicts++;
+            continue;
+        }
+        // Two robots trading places pass through each other mid-tick
+        auto other = occupant.find(before[i]);
+        if (here != before[i] && other != occupant.end() && other->second != i &&
+            before[other->second] == here)
+            conflicts++;
+    }
+    return conflicts;
+}
+
+bool SimulationContext::allRobotsIdle() const {
+    for (const auto& r : robots) {
+        if (r->state != EXPLORING || r->targetBox)
+            return false;
+    }
+    return true;
+}
+
+bool SimulationContext::stalled() const {
+    return ticks - lastProgressTick > STALL_TICKS + 4LL * (grid.rows + grid.cols);
+}
+
+RunResult SimulationContext::run(const std::function<void()>& afterStep) {
+    while (!allRobotsIdle() && !stalled() && (config.maxTicks == 0 || ticks < config.maxTicks)) {
+        step();
+        if (afterStep) afterStep();
+    }
+    if (stalled())
+        WLOG_WARN(SIM, "seed {}: no box moved since tick {}, giving up at tick {}", config.seed,
+                  lastProgressTick, ticks);
+    return result();
+}
+
+RunResult SimulationContext::result() const {
+    RunResult r;
+    r.completed = allRobotsIdle();
+    r.ticks = ticks;
+    r.movements = memory.getMovementCount();
+    r.elapsedMs = memory.getElapsedTimeMs();
+    r.waits = memory.getWaitCount();
+    r.conflicts = memory.getConflictCount();
+    return r;
+}
+
+void writeResultJson(std::ostream& out, const ScenarioConfig& config, const RunResult& result) {
+    out << "{\"rows\":" << config.rows
+        << ",\"cols\":" << config.cols
+        << ",\"robots\":" << config.robotCount
+        << ",\"boxes\":" << config.boxCount
+        << ",\"seed\":" << config.seed
+        << ",\"completed\":" << (result.completed ? "true" : "false")
+        << ",\"makespan\":" << (result.completed ? result.ticks : -1)
+        << ",\"ticks\":" << result.ticks
+        << ",\"elapsed_ms\":" << result.elapsedMs
+        << ",\"movements\":" << result.movements
+        << ",\"waits\":" << result.waits
+        << ",\"conflicts\":" << result.conflicts
+        << "}\n";
+}
+
+void writeResultCsvHeader(std::ostream& out) {
+    out << "rows,cols,robots,boxes,seed,completed,makespan,ticks,elapsed_ms,movements,waits,conflicts\n";
+}
+
+void writeResultCsv(std::ostream& out, const ScenarioConfig& config, const RunResult& result) {
+    out << config.rows << ',' << config.cols << ','
+        << config.robotCount << ',' << config.boxCount << ','
+        << config.seed << ',' << (result.completed ? 1 : 0) << ','
+        << (result.completed ? result.ticks : -1) << ','
+        << result.ticks << ',' << result.elapsedMs << ','
+        << result.movements << ',' << result.waits << ','
+        << result.conflicts << '\n';
+}
@@ -0,0 +1,104 @@
+#include "Snapshot.hpp"
+#include "Robot.hpp"
+#include "SimulationContext.hpp"
+
+#include <algorithm>
+
+namespace {
+
+bool cellBefore(const SnapshotBox& box, int cell) {
+    return box.cell < cell;
+}
+
+} // namespace
+
+SnapshotPublisher::SnapshotPublisher(SimulationContext& sim) : sim(sim) {
+    Grid& grid = sim.getGrid();
+
+    // Boxes on the floor; carried ones are drawn with their robot
+    const BoxStore& store = grid.boxStore();
+    for (size_t i = 0; i < store.size(); i++) {
+        const Box& box = store.at(i);
+        if (grid.boxAt(box.x, box.y) == store.handleAt(i))
+            boxes.push_back({grid.index(box.x, box.y), static_cast<uint8_t>(box.stackSize), box.isPivot});
+    }
+    std::sort(boxes.begin(), boxes.end(),
+              [](const SnapshotBox& a, const SnapshotBox& b) { return a.cell < b.cell; });
+
+    const SharedMemory& memory = sim.getMemory();
+    for (int slot = 0; slot < memory.pivotSlots(); slot++) {
+        pivots.push_back(memory.getPivot(slot));
+        const Box* p = grid.box(pivots.back());
+        pivotCells.push_back(p ? grid.index(p->x, p->y) : -1);
+    }
+
+    for (const Robot* r : grid.getRobots())
+        robots.push_back({r->x, r->y, r->x, r->y, r->carrying});
+
+    grid.addObserver(this);
+    publish();
+}
+
+SnapshotPublisher::~SnapshotPublisher() {
+    sim.getGrid().removeObserver(this);
+}
+
+void SnapshotPublisher::onCellChanged(int idx) {
+    changed.push_back(idx);
+}
+
+void SnapshotPublisher::applyChanges() {
+    const Grid& grid = sim.getGrid();
+
+    // The pivot flag is not a grid change, so new pivots are spotted here
+    for (size_t slot = 0; slot < pivots.size(); slot++) {
+        BoxHandle current = sim.getMemory().getPivot(static_cast<int>(slot));
+        if (current == pivots[slot]) continue;
+        if (pivotCells[slot] >= 0) changed.push_back(pivotCells[slot]);
+        const Box* p = grid.box(current);
+        pivots[slot] = current;
+        pivotCells[slot] = p ? grid.index(p->x, p->y) : -1;
+        if (pivotCells[slot] >= 0) changed.push_back(pivotCells[slot]);
+    }
+    if (changed.empty()) return;
+
+    for (int idx : changed) {
+        auto it = std::lower_bound(boxes.begin(), boxes.end(), idx, cellBefore);
+        bool listed = it != boxes.end() && it->cell == idx;
+
+        if (const Box* box = grid.box(grid.boxAt(idx))) {
+            SnapshotBox entry{idx, static_cast<uint8_t>(box->stackSize), box->isPivot};
+            if (listed) *it = entry;
+            else boxes.insert(it, entry);
+        } else if (listed) {
+            boxes.erase(it);
+        }
+    }
+    changed.clear();
+    boxVersion++;
+}
+
+void SnapshotPublisher::publish(bool finished) {
+    applyChanges();
+
+    const std::vector<Robot*>& all = sim.getGrid().getRobots();
+    for (size_t i = 0; i < all.size(); i++) {
+        SnapshotRobot& r = robots[i];
+        r.fromX = r.x;
+        r.fromY = r.y;
+        r.x = all[i]->x;
+        r.y = all[i]->y;
+        r.carrying = all[i]->carrying;
+    }
+
+    Snapshot& s = buffer.back();
+    s.tick = sim.getTick();
+    s.finished = finished;
+    s.publishedAt = std::chrono::steady_clock::now();
+    s.robots = robots;
+    if (s.boxVersion != boxVersion) {
+        s.boxes = boxes;
+        s.boxVersion = boxVersion;
+    }
+    buffer.publish();
+}
@@ -0,0 +1,369 @@
+#include "TaskAllocator.hpp"
+#include "Robot.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+// Cost of a box nobody can reach; such pairs are never handed out
+constexpr long long UNREACHABLE = 1000000000LL;
+
+CostMatrix transpose(const CostMatrix& cost) {
+    CostMatrix t(cost.empty() ? 0 : cost[0].size(), std::vector<long long>(cost.size()));
+    for (size_t i = 0; i < cost.size(); i++)
+        for (size_t j = 0; j < cost[i].size(); j++)
+            t[j][i] = cost[i][j];
+    return t;
+}
+
+// Turns a column-per-row answer for the transposed matrix back around
+std::vector<int> invert(const std::vector<int>& colOfRow, size_t rows) {
+    std::vector<int> result(rows, -1);
+    for (size_t j = 0; j < colOfRow.size(); j++)
+        if (colOfRow[j] >= 0) result[colOfRow[j]] = static_cast<int>(j);
+    return result;
+}
+
+} // namespace
+
+bool parseAssignMode(const std::string& text, AssignMode& mode) {
+    if (text == "negotiate") mode = AssignMode::NEGOTIATE;
+    else if (text == "auto") mode = AssignMode::AUTO;
+    else if (text == "hungarian") mode = AssignMode::HUNGARIAN;
+    else if (text == "auction") mode = AssignMode::AUCTION;
+    else return false;
+    return true;
+}
+
+const char* assignModeName(AssignMode mode) {
+    switch (mode) {
+        case AssignMode::NEGOTIATE: return "negotiate";
+        case AssignMode::AUTO: return "auto";
+        case AssignMode::HUNGARIAN: return "hungarian";
+        case AssignMode::AUCTION: return "auction";
+    }
+    return "auto";
+}
+
+std::vector<int> solveHungarian(const CostMatrix& cost) {
+    const int n = static_cast<int>(cost.size());
+    const int m = n ? static_cast<int>(cost[0].size()) : 0;
+    if (n == 0 || m == 0) return std::vector<int>(n, -1);
+    if (n > m) return invert(solveHungarian(transpose(cost)), n);
+
+    // Potentials u (rows) and v (columns), 1-based with column 0 as the sentinel
+    const long long INF = std::numeric_limits<long long>::max() / 4;
+    std::vector<long long> u(n + 1, 0), v(m + 1, 0);
+    std::vector<int> rowOf(m + 1, 0), way(m + 1, 0);
+
+    for (int i = 1; i <= n; i++) {
+        rowOf[0] = i;
+        int j0 = 0;
+        std::vector<long long> minv(m + 1, INF);
+        std::vector<char> used(m + 1, false);
+        do {
+            used[j0] = true;
+            int i0 = rowOf[j0], j1 = 0;
+            long long delta = INF;
+            for (int j = 1; j <= m; j++) {
+                if (used[j]) continue;
+                long long cur = cost[i0 - 1][j - 1] - u[i0] - v[j];
+                if (cur < minv[j]) { minv[j] = cur; way[j] = j0; }
+                if (minv[j] < delta) { delta = minv[j]; j1 = j; }
+            }
+            for (int j = 0; j <= m; j++) {
+                if (used[j]) { u[rowOf[j]] += delta; v[j] -= delta; }
+                else minv[j] -= delta;
+            }
+            j0 = j1;
+        } while (rowOf[j0] != 0);
+        do {
+            int j1 = way[j0];
+            rowOf[j0] = rowOf[j1];
+            j0 = j1;
+        } while (j0);
+    }
+
+    std::vector<int> result(n, -1);
+    for (int j = 1; j <= m; j++)
+        if (rowOf[j] > 0) result[rowOf[j] - 1] = j - 1;
+    return result;
+}
+
+bool AuctionSolver::bid(const SparseCosts& rows, long long slack, std::vector<long long>& price,
+                        std::vector<int>& colOf) const {
+    const long long NONE = std::numeric_limits<long long>::min();
+    colOf.assign(rows.size(), -1);
+    std::vector<int> ownerOf(price.size(), -1);
+    std::vector<size_t> unassigned;
+    for (size_t i = rows.size(); i-- > 0; )
+        unassigned.push_back(i);
+    bool without = false;
+
+    while (!unassigned.empty()) {
+        size_t i = unassigned.back();
+        unassigned.pop_back();
+
+        // Best and second-best net value (benefit is -cost)
+        int best = -1;
+        long long bestValue = NONE;
+        long long secondValue = NONE;
+        long long dearest = 0;
+        for (const auto& [j, c] : rows[i]) {
+            dearest = std::max(dearest, c);
+            long long value = -c - price[j];
+            if (value > bestValue) {
+                secondValue = bestValue;
+                bestValue = value;
+                best = j;
+            } else if (value > secondValue) {
+                secondValue = value;
+            }
+        }
+
+        // Going without counts as one more column, private to the row and free
+        if (slack >= 0) {
+            long long stay = -(dearest + slack);
+            if (best < 0 || stay > bestValue) {
+                without = true;
+                continue;
+            }
+            secondValue = std::max(secondValue, stay);
+        }
+        if (best < 0) continue;
+
+        long long increment = secondValue == NONE ? 1 : bestValue - secondValue + 1;
+        price[best] += increment;
+
+        if (ownerOf[best] >= 0) {
+            colOf[ownerOf[best]] = -1;
+            unassigned.push_back(ownerOf[best]);
+        }
+        ownerOf[best] = static_cast<int>(i);
+        colOf[i] = best;
+    }
+
+    // Once bid for a column is always taken, so only carried prices can leave
+    // one over that is dearer than the cheapest taken
+    long long cheapest = without ? 0 : std::numeric_limits<long long>::max();
+    for (size_t j = 0; j < price.size(); j++)
+        if (ownerOf[j] >= 0) cheapest = std::min(cheapest, price[j]);
+    for (size_t j = 0; j < price.size(); j++)
+        if (ownerOf[j] < 0 && price[j] > cheapest) return false;
+    return true;
+}
+
+std::vector<int> AuctionSolver::solve(const SparseCosts& rows, size_t columns,
+                                      const std::vector<uint64_t>& keys, long long slack) {
+    std::vector<long long> price(columns, 0);
+    bool carried = false;
+    for (size_t j = 0; j < columns; j++) {
+        auto it = keys[j] ? prices.find(keys[j]) : prices.end();
+        if (it == prices.end()) continue;
+        price[j] = it->second;
+        carried = true;
+    }
+    if (carried) {
+        long long lowest = *std::min_element(price.begin(), price.end());
+        for (long long& p : price)
+            p -= lowest;
+    }
+
+    std::vector<int> colOf;
+    if (!bid(rows, slack, price, colOf) && carried) {
+        std::fill(price.begin(), price.end(), 0);
+        bid(rows, slack, price, colOf);
+    }
+
+    for (size_t j = 0; j < columns; j++)
+        if (keys[j]) prices[keys[j]] = price[j];
+    return colOf;
+}
+
+std::vector<int> solveAuction(const CostMatrix& cost) {
+    const size_t n = cost.size();
+    const size_t m = n ? cost[0].size() : 0;
+    if (n == 0 || m == 0) return std::vector<int>(n, -1);
+
+    // With more bidders than objects the columns bid for the rows instead
+    if (n > m)
+        return invert(solveAuction(transpose(cost)), n);
+
+    SparseCosts rows(n);
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < m; j++)
+            rows[i].push_back({static_cast<int>(j), cost[i][j]});
+    AuctionSolver fresh;
+    return fresh.solve(rows, m, std::vector<uint64_t>(m, 0), -1);
+}
+
+TaskAllocator::TaskAllocator(AssignMode mode) : mode(mode) {}
+
+void TaskAllocator::distancesFrom(const Grid& grid, int source, const std::vector<int>& targets) {
+    if (static_cast<int>(stamp.size()) < grid.cellCount()) {
+        stamp.assign(grid.cellCount(), 0);
+        wanted.assign(grid.cellCount(), 0);
+        dist.resize(grid.cellCount());
+        generation = 0;
+    }
+    if (++generation == 0) {
+        std::fill(stamp.begin(), stamp.end(), 0);
+        std::fill(wanted.begin(), wanted.end(), 0);
+        generation = 1;
+    }
+
+    size_t remaining = 0;
+    for (int t : targets) {
+        if (wanted[t] != generation) remaining++;
+        wanted[t] = generation;
+    }
+
+    queue.clear();
+    queue.push_back(source);
+    stamp[source] = generation;
+    dist[source] = 0;
+
+    const int* offsets = grid.neighborOffsets();
+    for (size_t head = 0; head < queue.size() && remaining > 0; head++) {
+        int cur = queue[head];
+        for (int i = 0; i < 4; i++) {
+            int next = cur + offsets[i];
+            if (stamp[next] == generation || grid.isWall(next)) continue;
+            stamp[next] = generation;
+            dist[next] = dist[cur] + 1;
+
+            if (wanted[next] == generation && remaining > 0)
+                remaining--;
+            // Boxes end a path, they are never walked through
+            if (!grid.hasBox(next))
+                queue.push_back(next);
+        }
+    }
+}
+
+int TaskAllocator::allocate(const Grid& grid, const std::vector<std::unique_ptr<Robot>>& robots,
+                            const std::vector<FlowField*>& toPivots) {
+    std::vector<Robot*> free;
+    for (const auto& r : robots)
+        if (r->needsTask()) free.push_back(r.get());
+    if (free.empty()) return 0;
+
+    // Boxes on the floor nobody is heading for yet, in one sweep of the store
+    const BoxStore& store = grid.boxStore();
+    int maxStack = Box::targetLimit(!toPivots.empty());
+    std::vector<std::pair<int, BoxHandle>> open;
+    for (size_t i = 0; i < store.size(); i++) {
+        const Box& box = store.at(i);
+        if (box.isPivot || box.stackSize >= maxStack) continue;
+
+        // Carried boxes keep their last floor position
+        BoxHandle handle = store.handleAt(i);
+        int idx = grid.index(box.x, box.y);
+        if (grid.boxAt(idx) != handle) continue;
+
+        bool claimed = false;
+        for (const auto& r : robots)
+            if (r->targetBox == handle) { claimed = true; break; }
+        if (claimed) continue;
+
+        open.push_back({idx, handle});
+    }
+
+    // Store order shifts as boxes come and go; cell order keeps ties stable
+    std::sort(open.begin(), open.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    std::vector<BoxHandle> boxes;
+    std::vector<int> cells;
+    for (const auto& [idx, handle] : open) {
+        cells.push_back(idx);
+        boxes.push_back(handle);
+    }
+    if (boxes.empty()) return 0;
+
+    // Leg from each box to its nearest pivot (nothing to add before the first pivot)
+    std::vector<long long> leg(boxes.size(), toPivots.empty() ? 0 : UNREACHABLE);
+    for (FlowField* field : toPivots) {
+        for (size_t j = 0; j < boxes.size(); j++) {
+            int d = field->distance(cells[j]);
+            if (d >= 0) leg[j] = std::min<long long>(leg[j], d);
+        }
+    }
+
+    bool hungarian = mode == AssignMode::HUNGARIAN ||
+                     (mode == AssignMode::AUTO && static_cast<int>(free.size()) <= HUNGARIAN_LIMIT);
+    std::vector<int> choice = hungarian ? chooseByHungarian(grid, free, cells, leg)
+                                        : chooseByAuction(grid, free, boxes, cells, leg);
+
+    int assigned = 0;
+    for (size_t i = 0; i < free.size(); i++) {
+        int j = choice[i];
+        if (j < 0) continue;
+        free[i]->assignTask(boxes[j]);
+        if (!hungarian) auction.forget(boxes[j].key());
+        assigned++;
+    }
+    return assigned;
+}
+
+std::vector<int> TaskAllocator::chooseByHungarian(const Grid& grid, const std::vector<Robot*>& free,
+                                                  const std::vector<int>& cells,
+                                                  const std::vector<long long>& leg) {
+    CostMatrix cost(free.size(), std::vector<long long>(cells.size()));
+    for (size_t i = 0; i < free.size(); i++) {
+        distancesFrom(grid, grid.index(free[i]->x, free[i]->y), cells);
+        for (size_t j = 0; j < cells.size(); j++) {
+            int d = distanceTo(cells[j]);
+            cost[i][j] = d < 0 ? UNREACHABLE : std::min(d + leg[j], UNREACHABLE);
+        }
+    }
+
+    std::vector<int> choice = solveHungarian(cost);
+    for (size_t i = 0; i < free.size(); i++)
+        if (choice[i] >= 0 && cost[i][choice[i]] >= UNREACHABLE) choice[i] = -1;
+    return choice;
+}
+
+std::vector<int> TaskAllocator::chooseByAuction(const Grid& grid, const std::vector<Robot*>& free,
+                                                const std::vector<BoxHandle>& boxes,
+                                                const std::vector<int>& cells,
+                                                const std::vector<long long>& leg) {
+    // Candidates are the nearest open boxes with a way on to a pivot
+    if (static_cast<int>(columnAt.size()) < grid.cellCount())
+        columnAt.assign(grid.cellCount(), -1);
+    for (size_t j = 0; j < cells.size(); j++)
+        if (leg[j] < UNREACHABLE) columnAt[cells[j]] = static_cast<int>(j);
+    BoxFilter filter;
+    filter.skipPivots = true;
+    filter.accept = [&](BoxHandle handle, const Box& box) {
+        int j = columnAt[grid.index(box.x, box.y)];
+        return j >= 0 && boxes[j] == handle;
+    };
+
+    SparseCosts rows(free.size());
+    std::vector<BoxHandle> nearest;
+    std::vector<int> targets;
+    for (size_t i = 0; i < free.size(); i++) {
+        grid.boxIndex().nearest(free[i]->x, free[i]->y, AUCTION_CANDIDATES, filter, nearest);
+        targets.clear();
+        for (BoxHandle handle : nearest) {
+            const Box* box = grid.box(handle);
+            targets.push_back(grid.index(box->x, box->y));
+        }
+        distancesFrom(grid, grid.index(free[i]->x, free[i]->y), targets);
+        for (int idx : targets) {
+            int d = distanceTo(idx);
+            int j = columnAt[idx];
+            if (d >= 0) rows[i].push_back({j, std::min(d + leg[j], UNREACHABLE)});
+        }
+    }
+    for (int idx : cells)
+        columnAt[idx] = -1;
+
+    // A robot outbid on every candidate waits rather than take a dearer box
+    // it never priced; next tick it looks again without the boxes handed out
+    std::vector<uint64_t> keys;
+    for (BoxHandle box : boxes)
+        keys.push_back(box.key());
+    return auction.solve(rows, boxes.size(), keys, 0);
+}
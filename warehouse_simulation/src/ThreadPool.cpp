@@ -0,0 +1,97 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+
+    for (unsigned i = 0; i < threads; i++)
+        queues.push_back(std::make_unique<Queue>());
+    for (unsigned i = 0; i < threads; i++)
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    taskReady.notify_all();
+    for (auto& w : workers)
+        w.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    pending++;
+    Queue& q = *queues[nextQueue++ % queues.size()];
+    {
+        std::lock_guard<std::mutex> lock(q.mtx);
+        q.tasks.push_back(std::move(task));
+    }
+    queued++;
+
+    // Taking the lock orders this wake-up after a worker's last empty check
+    { std::lock_guard<std::mutex> lock(mtx); }
+    taskReady.notify_one();
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& body) {
+    if (count == 0) return;
+
+    // A few chunks per worker: enough to balance uneven items, few enough to stay cheap
+    size_t chunks = std::min(count, static_cast<size_t>(size()) * 4);
+    size_t per = (count + chunks - 1) / chunks;
+    for (size_t begin = 0; begin < count; begin += per) {
+        size_t end = std::min(count, begin + per);
+        submit([&body, begin, end] {
+            for (size_t i = begin; i < end; i++)
+                body(i);
+        });
+    }
+    wait();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mtx);
+    allDone.wait(lock, [this] { return pending == 0; });
+}
+
+bool ThreadPool::tryTake(unsigned self, std::function<void()>& task) {
+    // Own deque first (newest task), then steal the oldest from the others
+    for (size_t k = 0; k < queues.size(); k++) {
+        Queue& q = *queues[(self + k) % queues.size()];
+        std::lock_guard<std::mutex> lock(q.mtx);
+        if (q.tasks.empty()) continue;
+
+        if (k == 0) {
+            task = std::move(q.tasks.back());
+            q.tasks.pop_back();
+        } else {
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+        }
+        queued--;
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(unsigned self) {
+    while (true) {
+        std::function<void()> task;
+        if (!tryTake(self, task)) {
+            std::unique_lock<std::mutex> lock(mtx);
+            taskReady.wait(lock, [this] { return stopping || queued > 0; });
+            if (stopping && queued == 0) return;
+            continue;
+        }
+
+        task();
+
+        if (--pending == 0) {
+            std::lock_guard<std::mutex> lock(mtx);
+            allDone.notify_all();
+        }
+    }
+}
@@ -0,0 +1,542 @@
+#include "Trace.hpp"
+#include "SimulationContext.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <ostream>
+
+namespace {
+
+const char MAGIC[8] = {'W', 'H', 'T', 'R', 'A', 'C', 'E', 1};
+
+// Block tags
+constexpr uint8_t KEYFRAME = 'K';
+constexpr uint8_t TICK = 'T';
+constexpr uint8_t INDEX = 'E';
+
+// Move codes: right, left, down, up as in Grid::neighborOffsets, or a jump
+// followed by the zigzag-encoded offsets
+constexpr int JUMP = 4;
+const int DX[4] = {1, -1, 0, 0};
+const int DY[4] = {0, 0, 1, -1};
+
+// How a message's conversation id relates to its sender and receiver
+constexpr uint8_t CONV_SENDER = 0;      // started by the sender: low half follows
+constexpr uint8_t CONV_RECEIVER = 1;    // started by the receiver: low half follows
+constexpr uint8_t CONV_FULL = 2;        // anything else: the whole id follows
+
+void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void putSigned(std::vector<uint8_t>& out, long long value) {
+    putVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+bool getVarint(const std::vector<uint8_t>& in, size_t& pos, size_t end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; pos < end && shift < 64; shift += 7) {
+        uint8_t byte = in[pos++];
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+bool getSigned(const std::vector<uint8_t>& in, size_t& pos, size_t end, long long& value) {
+    uint64_t raw;
+    if (!getVarint(in, pos, end, raw)) return false;
+    value = static_cast<long long>(raw >> 1) ^ -static_cast<long long>(raw & 1);
+    return true;
+}
+
+// Tag, payload length, payload
+void putBlock(std::vector<uint8_t>& out, uint8_t tag, const std::vector<uint8_t>& payload) {
+    out.push_back(tag);
+    putVarint(out, payload.size());
+    out.insert(out.end(), payload.begin(), payload.end());
+}
+
+// Reads a block header at pos; on success pos is the payload start
+bool getBlock(const std::vector<uint8_t>& in, size_t& pos, uint8_t& tag, size_t& end) {
+    if (pos >= in.size()) return false;
+    tag = in[pos++];
+    uint64_t length;
+    if (!getVarint(in, pos, in.size(), length) || length > in.size() - pos) return false;
+    end = pos + static_cast<size_t>(length);
+    return true;
+}
+
+} // namespace
+
+// ---- recording -------------------------------------------------------------
+
+TraceRecorder::TraceRecorder(std::ostream& out, int keyframeEvery)
+    : out(out), keyframeEvery(keyframeEvery) {}
+
+void TraceRecorder::begin(SimulationContext& context) {
+    const Grid& grid = context.getGrid();
+    cols = grid.cols;
+
+    buffer.assign(MAGIC, MAGIC + sizeof(MAGIC));
+    putVarint(buffer, static_cast<uint64_t>(grid.rows));
+    putVarint(buffer, static_cast<uint64_t>(grid.cols));
+    putVarint(buffer, context.getConfig().seed);
+    putVarint(buffer, static_cast<uint64_t>(keyframeEvery));
+
+    // Wall bitmap, row-major, least significant bit first
+    uint8_t bits = 0;
+    int filled = 0;
+    for (int y = 0; y < grid.rows; y++) {
+        for (int x = 0; x < grid.cols; x++) {
+            if (grid.isWall(x, y)) bits |= static_cast<uint8_t>(1u << filled);
+            if (++filled == 8) {
+                buffer.push_back(bits);
+                bits = 0;
+                filled = 0;
+            }
+        }
+    }
+    if (filled) buffer.push_back(bits);
+    flush();
+
+    for (const auto& r : context.getRobots())
+        lastPositions.push_back({r->x, r->y});
+    writeKeyframe(context);
+}
+
+void TraceRecorder::pick(acl::AgentId robot, int x, int y) {
+    events.push_back(static_cast<uint8_t>(TraceEventKind::PICK));
+    putVarint(events, robot);
+    putVarint(events, static_cast<uint64_t>(y * cols + x));
+    eventCount++;
+}
+
+void TraceRecorder::stack(acl::AgentId robot, int x, int y, int height) {
+    events.push_back(static_cast<uint8_t>(TraceEventKind::STACK));
+    putVarint(events, robot);
+    putVarint(events, static_cast<uint64_t>(y * cols + x));
+    events.push_back(static_cast<uint8_t>(height));
+    eventCount++;
+}
+
+void TraceRecorder::pivot(int x, int y, bool on) {
+    events.push_back(static_cast<uint8_t>(on ? TraceEventKind::PIVOT_ON : TraceEventKind::PIVOT_OFF));
+    putVarint(events, static_cast<uint64_t>(y * cols + x));
+    eventCount++;
+}
+
+void TraceRecorder::endTick(SimulationContext& context) {
+    std::vector<uint8_t> payload;
+
+    // Moves, by increasing robot id: the gap to the previous mover and the direction
+    const auto& robots = context.getRobots();
+    std::vector<uint8_t> moves;
+    uint64_t moveCount = 0;
+    size_t nextRobot = 0;
+    for (size_t i = 0; i < robots.size(); i++) {
+        int dx = robots[i]->x - lastPositions[i].first;
+        int dy = robots[i]->y - lastPositions[i].second;
+        if (!dx && !dy) continue;
+
+        int code = JUMP;
+        for (int d = 0; d < 4; d++)
+            if (dx == DX[d] && dy == DY[d]) code = d;
+
+        putVarint(moves, (static_cast<uint64_t>(i - nextRobot) << 3) | static_cast<uint64_t>(code));
+        if (code == JUMP) {
+            putSigned(moves, dx);
+            putSigned(moves, dy);
+        }
+        lastPositions[i] = {robots[i]->x, robots[i]->y};
+        nextRobot = i + 1;
+        moveCount++;
+    }
+    putVarint(payload, moveCount);
+    payload.insert(payload.end(), moves.begin(), moves.end());
+
+    putVarint(payload, eventCount);
+    payload.insert(payload.end(), events.begin(), events.end());
+    events.clear();
+    eventCount = 0;
+
+    // Messages delivered this tick, which the registry holds in sender order
+    const std::vector<acl::ACLMessage>& mail = context.getRegistry().deliveredMail();
+    putVarint(payload, mail.size());
+    acl::AgentId prevSender = 0;
+    for (const acl::ACLMessage& msg : mail) {
+        uint8_t conv = CONV_FULL;
+        if ((msg.conversationId >> 32) == msg.sender) conv = CONV_SENDER;
+        else if (msg.receiver != acl::NO_AGENT && (msg.conversationId >> 32) == msg.receiver) conv = CONV_RECEIVER;
+
+        putSigned(payload, static_cast<long long>(msg.sender) - prevSender);
+        payload.push_back(static_cast<uint8_t>(static_cast<uint8_t>(msg.performative) | (conv << 4) |
+                                               (msg.content.index() << 6)));
+        putVarint(payload, msg.receiver == acl::NO_AGENT ? 0 : static_cast<uint64_t>(msg.receiver) + 1);
+        putVarint(payload, conv == CONV_FULL ? msg.conversationId : (msg.conversationId & 0xffffffffu));
+
+        if (const acl::BoxQuery* q = std::get_if<acl::BoxQuery>(&msg.content)) {
+            putSigned(payload, q->x);
+            putSigned(payload, q->y);
+        } else if (const acl::Availability* a = std::get_if<acl::Availability>(&msg.content)) {
+            payload.push_back(a->available ? 1 : 0);
+        }
+        prevSender = msg.sender;
+    }
+
+    putBlock(buffer, TICK, payload);
+    flush();
+
+    if (keyframeEvery > 0 && context.getTick() % keyframeEvery == 0)
+        writeKeyframe(context);
+}
+
+void TraceRecorder::writeKeyframe(SimulationContext& context) {
+    const Grid& grid = context.getGrid();
+    std::vector<uint8_t> payload;
+    putVarint(payload, static_cast<uint64_t>(context.getTick()));
+
+    const auto& robots = context.getRobots();
+    putVarint(payload, robots.size());
+    for (const auto& r : robots) {
+        putVarint(payload, static_cast<uint64_t>(r->x));
+        putVarint(payload, static_cast<uint64_t>(r->y));
+        payload.push_back(r->carrying ? 1 : 0);
+    }
+
+    // Boxes on the floor by cell; carried ones are implied by their robot
+    std::vector<std::pair<int, uint8_t>> floor;
+    const BoxStore& store = grid.boxStore();
+    for (size_t i = 0; i < store.size(); i++) {
+        const Box& b = store.at(i);
+        if (grid.boxAt(b.x, b.y) != store.handleAt(i)) continue;
+        floor.push_back({b.y * grid.cols + b.x, static_cast<uint8_t>(b.stackSize | (b.isPivot ? 0x80 : 0))});
+    }
+    std::sort(floor.begin(), floor.end());
+
+    putVarint(payload, floor.size());
+    int prevCell = 0;
+    for (const auto& [cell, value] : floor) {
+        putVarint(payload, static_cast<uint64_t>(cell - prevCell));
+        payload.push_back(value);
+        prevCell = cell;
+    }
+
+    keyframes.push_back({context.getTick(), written});
+    putBlock(buffer, KEYFRAME, payload);
+    flush();
+}
+
+void TraceRecorder::finish() {
+    if (finished) return;
+    finished = true;
+
+    std::vector<uint8_t> payload;
+    putVarint(payload, keyframes.size());
+    long long prevTick = 0, prevOffset = 0;
+    for (const auto& [tick, offset] : keyframes) {
+        putVarint(payload, static_cast<uint64_t>(tick - prevTick));
+        putVarint(payload, static_cast<uint64_t>(offset - prevOffset));
+        prevTick = tick;
+        prevOffset = offset;
+    }
+
+    // The fixed-size trailer points back at the index block
+    uint64_t at = static_cast<uint64_t>(written);
+    putBlock(buffer, INDEX, payload);
+    for (int i = 0; i < 8; i++)
+        buffer.push_back(static_cast<uint8_t>(at >> (8 * i)));
+    flush();
+    out.flush();
+}
+
+void TraceRecorder::flush() {
+    out.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    written += static_cast<long long>(buffer.size());
+    buffer.clear();
+}
+
+// ---- replay ------------------------------------------------------------------
+
+bool TraceReplayer::open(const std::string& path, std::string& error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "cannot read " + path;
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+    if (!readHeader(error))
+        return false;
+    indexKeyframes();
+    if (keyframes.empty() || keyframes.front().first != 0) {
+        error = path + " has no initial keyframe";
+        return false;
+    }
+    seek(0);
+    return true;
+}
+
+bool TraceReplayer::readHeader(std::string& error) {
+    if (data.size() < sizeof(MAGIC) || std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0) {
+        error = "not a warehouse trace";
+        return false;
+    }
+
+    size_t pos = sizeof(MAGIC);
+    uint64_t rows, cols, seed, every;
+    if (!getVarint(data, pos, data.size(), rows) || !getVarint(data, pos, data.size(), cols) ||
+        !getVarint(data, pos, data.size(), seed) || !getVarint(data, pos, data.size(), every) ||
+        rows == 0 || cols == 0 || rows * cols > (1u << 28)) {
+        error = "corrupt trace header";
+        return false;
+    }
+
+    size_t cells = static_cast<size_t>(rows * cols);
+    if (data.size() - pos < (cells + 7) / 8) {
+        error = "corrupt trace header";
+        return false;
+    }
+
+    layout.rows = static_cast<int>(rows);
+    layout.cols = static_cast<int>(cols);
+    layout.walls.resize(cells);
+    for (size_t i = 0; i < cells; i++)
+        layout.walls[i] = (data[pos + i / 8] >> (i % 8)) & 1;
+    layout.cells.assign(cells, TraceCell());
+    pos += (cells + 7) / 8;
+
+    runSeed = static_cast<unsigned>(seed);
+    keyframeEvery = static_cast<int>(every);
+    body = pos;
+    return true;
+}
+
+void TraceReplayer::indexKeyframes() {
+    keyframes.clear();
+
+    // Complete trace: the trailer points at the index
+    if (data.size() >= body + 8) {
+        uint64_t at = 0;
+        for (int i = 0; i < 8; i++)
+            at |= static_cast<uint64_t>(data[data.size() - 8 + i]) << (8 * i);
+
+        size_t pos = static_cast<size_t>(at), end;
+        uint8_t tag;
+        uint64_t count;
+        if (at >= body && at < data.size() - 8 && getBlock(data, pos, tag, end) && tag == INDEX &&
+            end == data.size() - 8 && getVarint(data, pos, end, count)) {
+            long long tick = 0;
+            size_t offset = 0;
+            bool ok = true;
+            for (uint64_t i = 0; i < count && ok; i++) {
+                uint64_t dt = 0, doff = 0;
+                ok = getVarint(data, pos, end, dt) && getVarint(data, pos, end, doff);
+                tick += static_cast<long long>(dt);
+                offset += static_cast<size_t>(doff);
+                keyframes.push_back({tick, offset});
+            }
+
+            // Tick blocks between the last keyframe and the index
+            if (ok && !keyframes.empty()) {
+                last = keyframes.back().first;
+                size_t scan = keyframes.back().second;
+                while (getBlock(data, scan, tag, end) && tag != INDEX) {
+                    if (tag == TICK) last++;
+                    scan = end;
+                }
+                return;
+            }
+            keyframes.clear();
+        }
+    }
+
+    // Cut short: walk every block up to the last complete one
+    last = 0;
+    size_t pos = body, end;
+    uint8_t tag;
+    for (size_t start = pos; getBlock(data, pos, tag, end) && tag != INDEX; start = pos = end) {
+        if (tag == KEYFRAME) keyframes.push_back({last, start});
+        else if (tag == TICK) last++;
+    }
+}
+
+bool TraceReplayer::readKeyframe(size_t& pos, TraceState& into) const {
+    uint8_t tag;
+    size_t end;
+    if (!getBlock(data, pos, tag, end) || tag != KEYFRAME) return false;
+
+    uint64_t tick, robots, boxes;
+    if (!getVarint(data, pos, end, tick) || !getVarint(data, pos, end, robots)) return false;
+    into.tick = static_cast<long long>(tick);
+    into.robots.assign(static_cast<size_t>(std::min<uint64_t>(robots, end - pos)), TraceRobot());
+    for (TraceRobot& r : into.robots) {
+        uint64_t x, y;
+        if (!getVarint(data, pos, end, x) || !getVarint(data, pos, end, y) || pos >= end) return false;
+        r.x = static_cast<int>(x);
+        r.y = static_cast<int>(y);
+        r.carrying = data[pos++] != 0;
+    }
+
+    std::fill(into.cells.begin(), into.cells.end(), TraceCell());
+    if (!getVarint(data, pos, end, boxes)) return false;
+    size_t cell = 0;
+    for (uint64_t i = 0; i < boxes; i++) {
+        uint64_t delta;
+        if (!getVarint(data, pos, end, delta) || pos >= end) return false;
+        cell += static_cast<size_t>(delta);
+        if (cell >= into.cells.size()) return false;
+        uint8_t value = data[pos++];
+        into.cells[cell].height = value & 0x7f;
+        into.cells[cell].pivot = (value & 0x80) != 0;
+    }
+
+    into.events.clear();
+    into.messages.clear();
+    pos = end;
+    return true;
+}
+
+bool TraceReplayer::applyTick(size_t& pos, TraceState& into) const {
+    uint8_t tag;
+    size_t end;
+    if (!getBlock(data, pos, tag, end) || tag != TICK) return false;
+    into.events.clear();
+    into.messages.clear();
+
+    uint64_t count;
+    if (!getVarint(data, pos, end, count)) return false;
+    size_t robot = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t move;
+        if (!getVarint(data, pos, end, move)) return false;
+        robot += static_cast<size_t>(move >> 3);
+        if (robot >= into.robots.size()) return false;
+
+        int code = static_cast<int>(move & 7);
+        TraceRobot& r = into.robots[robot++];
+        if (code < JUMP) {
+            r.x += DX[code];
+            r.y += DY[code];
+        } else {
+            long long dx, dy;
+            if (!getSigned(data, pos, end, dx) || !getSigned(data, pos, end, dy)) return false;
+            r.x += static_cast<int>(dx);
+            r.y += static_cast<int>(dy);
+        }
+    }
+
+    if (!getVarint(data, pos, end, count)) return false;
+    for (uint64_t i = 0; i < count; i++) {
+        if (pos >= end) return false;
+        TraceEvent e;
+        e.kind = static_cast<TraceEventKind>(data[pos++]);
+
+        uint64_t value, cell;
+        bool byRobot = e.kind == TraceEventKind::PICK || e.kind == TraceEventKind::STACK;
+        if (byRobot) {
+            if (!getVarint(data, pos, end, value) || value >= into.robots.size()) return false;
+            e.robot = static_cast<acl::AgentId>(value);
+        }
+        if (!getVarint(data, pos, end, cell) || cell >= into.cells.size()) return false;
+        e.x = static_cast<int>(cell % static_cast<uint64_t>(into.cols));
+        e.y = static_cast<int>(cell / static_cast<uint64_t>(into.cols));
+
+        TraceCell& c = into.cells[static_cast<size_t>(cell)];
+        switch (e.kind) {
+            case TraceEventKind::PICK:
+                c = TraceCell();
+                into.robots[e.robot].carrying = true;
+                break;
+            case TraceEventKind::STACK:
+                if (pos >= end) return false;
+                e.height = data[pos++];
+                c.height = static_cast<uint8_t>(e.height);
+                into.robots[e.robot].carrying = false;
+                break;
+            case TraceEventKind::PIVOT_ON:
+                c.pivot = true;
+                break;
+            case TraceEventKind::PIVOT_OFF:
+                c.pivot = false;
+                break;
+            default:
+                return false;
+        }
+        into.events.push_back(e);
+    }
+
+    if (!getVarint(data, pos, end, count)) return false;
+    long long sender = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        long long delta;
+        uint64_t receiver, conv;
+        if (!getSigned(data, pos, end, delta) || pos >= end) return false;
+        sender += delta;
+        uint8_t packed = data[pos++];
+        if (!getVarint(data, pos, end, receiver) || !getVarint(data, pos, end, conv)) return false;
+
+        acl::AgentId from = static_cast<acl::AgentId>(sender);
+        acl::AgentId to = receiver == 0 ? acl::NO_AGENT : static_cast<acl::AgentId>(receiver - 1);
+        uint8_t convKind = (packed >> 4) & 3;
+        if (convKind == CONV_SENDER) conv |= static_cast<uint64_t>(from) << 32;
+        else if (convKind == CONV_RECEIVER) conv |= static_cast<uint64_t>(to) << 32;
+
+        acl::Content content;
+        switch (packed >> 6) {
+            case 1: {
+                long long x, y;
+                if (!getSigned(data, pos, end, x) || !getSigned(data, pos, end, y)) return false;
+                content = acl::BoxQuery{static_cast<int>(x), static_cast<int>(y)};
+                break;
+            }
+            case 2:
+                if (pos >= end) return false;
+                content = acl::Availability{data[pos++] != 0};
+                break;
+            default:
+                break;
+        }
+
+        into.messages.emplace_back(static_cast<acl::Performative>(packed & 0x0f), from, to, content,
+                                   acl::Language::SL, acl::Ontology::WAREHOUSE,
+                                   acl::Protocol::FIPA_CONTRACT_NET, conv);
+    }
+
+    into.tick++;
+    pos = end;
+    return true;
+}
+
+void TraceReplayer::seek(long long tick) {
+    tick = std::max(0LL, std::min(tick, last));
+
+    // Start from the keyframe before the tick, so its own events are replayed
+    auto it = std::upper_bound(keyframes.begin(), keyframes.end(), std::make_pair(std::max(0LL, tick - 1), SIZE_MAX));
+    --it;
+
+    current = layout;
+    cursor = it->second;
+    readKeyframe(cursor, current);
+    while (current.tick < tick && next()) {}
+}
+
+bool TraceReplayer::next() {
+    uint8_t tag;
+    size_t end;
+    while (current.tick < last) {
+        size_t pos = cursor;
+        if (!getBlock(data, pos, tag, end)) return false;
+        if (tag == TICK)
+            return applyTick(cursor, current);
+        // Keyframes only repeat the state we already have
+        cursor = end;
+    }
+    return false;
+}
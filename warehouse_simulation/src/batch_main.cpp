@@ -0,0 +1,207 @@
+// Batch driver: runs many independent headless simulations (seeds times
+// parameter combinations) on a thread pool and writes one row per run.
+#include "Log.hpp"
+#include "Scenario.hpp"
+#include "SimulationContext.hpp"
+#include "ThreadPool.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <sstream>
+
+namespace {
+
+struct BatchOptions {
+    int runs = 1;                   // seeds per parameter combination
+    unsigned threads = 0;           // 0 -> one per core
+    bool json = false;
+    std::string outputPath;         // empty -> stdout
+    std::vector<int> sizes;         // square grid sizes to sweep
+    std::vector<int> robotCounts;
+    std::vector<int> boxCounts;
+};
+
+bool parseList(const char* text, std::vector<int>& out) {
+    if (!text) return false;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        char* end = nullptr;
+        long v = std::strtol(item.c_str(), &end, 10);
+        if (item.empty() || *end != '\0' || v < 0) return false;
+        out.push_back(static_cast<int>(v));
+    }
+    return !out.empty();
+}
+
+void printBatchUsage(std::ostream& out, const char* program) {
+    out << "Usage: " << program << " [batch options] [scenario options]\n"
+        << "  --runs N             seeds per parameter combination, starting at --seed (default 1)\n"
+        << "  --threads N          worker threads (default: one per core)\n"
+        << "  --format csv|json    row format (default csv)\n"
+        << "  --output FILE        write rows to FILE instead of stdout\n"
+        << "  --sweep-size A,B     square grid sizes to sweep\n"
+        << "  --sweep-robots A,B   robot counts to sweep\n"
+        << "  --sweep-boxes A,B    box counts to sweep\n"
+        << "  (--max-ticks defaults to 100000 in batch mode)\n\n";
+    printScenarioUsage(out, program);
+}
+
+// Splits argv into batch options and the scenario options left for parseScenarioArgs
+bool parseBatchArgs(int argc, char** argv, BatchOptions& options,
+                    std::vector<char*>& scenarioArgs, std::string& error) {
+    scenarioArgs.push_back(argv[0]);
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (arg == "--runs" || arg == "--threads") {
+            char* end = nullptr;
+            long v = value ? std::strtol(value, &end, 10) : -1;
+            if (!value || *end != '\0' || v < 0) {
+                error = arg + " expects a non-negative integer";
+                return false;
+            }
+            if (arg == "--runs") options.runs = static_cast<int>(v);
+            else options.threads = static_cast<unsigned>(v);
+            i++;
+        } else if (arg == "--format") {
+            std::string format = value ? value : "";
+            if (format != "csv" && format != "json") {
+                error = "--format expects csv or json";
+                return false;
+            }
+            options.json = (format == "json");
+            i++;
+        } else if (arg == "--output") {
+            if (!value) {
+                error = "--output expects a file name";
+                return false;
+            }
+            options.outputPath = value;
+            i++;
+        } else if (arg == "--sweep-size" || arg == "--sweep-robots" || arg == "--sweep-boxes") {
+            std::vector<int>& list = (arg == "--sweep-size") ? options.sizes
+                                   : (arg == "--sweep-robots") ? options.robotCounts
+                                   : options.boxCounts;
+            if (!parseList(value, list)) {
+                error = arg + " expects a comma-separated list of integers";
+                return false;
+            }
+            i++;
+        } else {
+            scenarioArgs.push_back(argv[i]);
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BatchOptions options;
+    ScenarioConfig base;
+    std::vector<char*> scenarioArgs;
+    std::string error;
+
+    if (!parseBatchArgs(argc, argv, options, scenarioArgs, error) ||
+        !parseScenarioArgs(static_cast<int>(scenarioArgs.size()), scenarioArgs.data(), base, error)) {
+        std::cerr << "ERROR: " << error << "\n";
+        printBatchUsage(std::cerr, argv[0]);
+        return 2;
+    }
+    if (!base.offscreenPath.empty()) {
+        std::cerr << "ERROR: --offscreen is only supported by the windowed binary\n";
+        return 2;
+    }
+    if (!base.metricsPath.empty() || !base.tracePath.empty()) {
+        std::cerr << "ERROR: --metrics and --trace are only supported by the headless runner\n";
+        return 2;
+    }
+    // Every job shares the one loaded layout, which fixes the grid size and possibly the boxes
+    if (base.layout && (!options.sizes.empty() || (base.layout->boxCount() > 0 && !options.boxCounts.empty()))) {
+        std::cerr << "ERROR: --layout fixes the grid size and its boxes; drop --sweep-size or --sweep-boxes\n";
+        return 2;
+    }
+
+    // A stuck run must not hold a worker forever
+    if (base.maxTicks == 0) base.maxTicks = 100000;
+
+    if (options.sizes.empty()) options.sizes.push_back(-1);
+    if (options.robotCounts.empty()) options.robotCounts.push_back(base.robotCount);
+    if (options.boxCounts.empty()) options.boxCounts.push_back(base.boxCount);
+
+    // Cartesian product of the sweeps, each repeated for `runs` consecutive seeds
+    std::vector<ScenarioConfig> jobs;
+    for (int size : options.sizes)
+        for (int robotCount : options.robotCounts)
+            for (int boxCount : options.boxCounts)
+                for (int run = 0; run < options.runs; run++) {
+                    ScenarioConfig job = base;
+                    if (size > 0) job.rows = job.cols = size;
+                    job.robotCount = robotCount;
+                    job.boxCount = boxCount;
+                    job.seed = base.seed + static_cast<unsigned int>(run);
+                    job.verbose = false;
+                    jobs.push_back(job);
+                }
+
+    std::ofstream file;
+    if (!options.outputPath.empty()) {
+        file.open(options.outputPath);
+        if (!file) {
+            std::cerr << "ERROR: cannot open " << options.outputPath << "\n";
+            return 2;
+        }
+    }
+    std::ostream out(options.outputPath.empty() ? std::cout.rdbuf() : file.rdbuf());
+    logging::start(std::cerr, logging::Level::WARN);
+
+    if (!options.json)
+        writeResultCsvHeader(out);
+
+    // Rows are written in job order as soon as every earlier job has finished
+    std::vector<std::optional<RunResult>> results(jobs.size());
+    std::vector<std::string> errors(jobs.size());
+    size_t nextToWrite = 0;
+    std::mutex outputMtx;
+    int failures = 0;
+
+    ThreadPool pool(options.threads);
+
+    for (size_t i = 0; i < jobs.size(); i++) {
+        pool.submit([&, i] {
+            SimulationContext sim(jobs[i]);
+            std::string jobError;
+            RunResult result;
+
+            if (sim.populate(jobError))
+                result = sim.run();
+
+            std::lock_guard<std::mutex> lock(outputMtx);
+            results[i] = result;
+            errors[i] = jobError;
+
+            while (nextToWrite < jobs.size() && results[nextToWrite]) {
+                if (!errors[nextToWrite].empty()) {
+                    std::cerr << "ERROR: run " << nextToWrite << ": " << errors[nextToWrite] << "\n";
+                    failures++;
+                } else if (options.json) {
+                    writeResultJson(out, jobs[nextToWrite], *results[nextToWrite]);
+                } else {
+                    writeResultCsv(out, jobs[nextToWrite], *results[nextToWrite]);
+                }
+                nextToWrite++;
+            }
+            out.flush();
+        });
+    }
+
+    pool.wait();
+    logging::stop();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,431 @@
+// Benchmark driver. Micro-benchmarks time the hot paths in isolation (path
+// search on synthetic layouts, nearest-box lookup, ACL round trips, stacking);
+// macro-benchmarks time whole headless runs at fixed seeds. Every benchmark
+// has a fixed name and runs in a fixed order, and the output is one row per
+// benchmark, so the results of two builds can be joined on the name column.
+#include "AgentRegistry.hpp"
+#include "Log.hpp"
+#include "PathPlanner.hpp"
+#include "Scenario.hpp"
+#include "SimulationContext.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+
+namespace {
+
+struct BenchOptions {
+    std::string filter;             // substring of the benchmark name; empty -> all
+    int samples = 5;
+    long long minSampleNs = 100000000;  // a sample repeats the operation for at least this long
+    int maxSize = 4096;             // largest synthetic grid side
+    bool json = false;
+    std::string outputPath;         // empty -> stdout
+};
+
+struct BenchResult {
+    std::string name;
+    long long iterations = 0;       // per sample
+    double medianNs = 0;            // per operation
+    double minNs = 0;
+    double maxNs = 0;
+};
+
+// Results feed into this so the compiler cannot drop the work
+volatile size_t sink = 0;
+
+void printBenchUsage(std::ostream& out, const char* program) {
+    out << "Usage: " << program << " [options]\n"
+        << "  --filter TEXT        only run benchmarks whose name contains TEXT\n"
+        << "  --samples N          timed samples per benchmark (default 5)\n"
+        << "  --min-time-ms N      minimum length of one sample (default 100)\n"
+        << "  --max-size N         largest synthetic grid side, 64..4096 (default 4096)\n"
+        << "  --format csv|json    row format (default csv)\n"
+        << "  --output FILE        write rows to FILE instead of stdout\n";
+}
+
+bool parseBenchArgs(int argc, char** argv, BenchOptions& options, std::string& error) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (!value) {
+            error = arg + " expects a value";
+            return false;
+        }
+        i++;
+
+        if (arg == "--filter") {
+            options.filter = value;
+        } else if (arg == "--output") {
+            options.outputPath = value;
+        } else if (arg == "--format") {
+            std::string format = value;
+            if (format != "csv" && format != "json") {
+                error = "--format expects csv or json";
+                return false;
+            }
+            options.json = format == "json";
+        } else if (arg == "--samples" || arg == "--min-time-ms" || arg == "--max-size") {
+            char* end = nullptr;
+            long long v = std::strtoll(value, &end, 10);
+            if (*end != '\0' || v < 1) {
+                error = arg + " expects a positive integer";
+                return false;
+            }
+            if (arg == "--samples") options.samples = static_cast<int>(v);
+            else if (arg == "--min-time-ms") options.minSampleNs = v * 1000000;
+            else options.maxSize = static_cast<int>(v);
+        } else {
+            error = "unknown option " + arg;
+            return false;
+        }
+    }
+    return true;
+}
+
+class Bench {
+public:
+    Bench(const BenchOptions& options, std::ostream& out) : options(options), out(out) {
+        if (!options.json)
+            out << "benchmark,iterations,median_ns,min_ns,max_ns\n";
+    }
+
+    bool wanted(const std::string& name) const {
+        return options.filter.empty() || name.find(options.filter) != std::string::npos;
+    }
+
+    // Times `op`, which returns anything that can be added into the sink.
+    // One untimed call warms caches and sizes the samples.
+    template <class Op>
+    void run(const std::string& name, Op&& op) {
+        if (!wanted(name)) return;
+        using Clock = std::chrono::steady_clock;
+
+        auto t0 = Clock::now();
+        sink = sink + static_cast<size_t>(op());
+        long long once = std::max<long long>(1, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                    Clock::now() - t0).count());
+
+        BenchResult r;
+        r.name = name;
+        r.iterations = std::max<long long>(1, options.minSampleNs / once);
+
+        std::vector<double> perOp;
+        for (int s = 0; s < options.samples; s++) {
+            auto start = Clock::now();
+            for (long long i = 0; i < r.iterations; i++)
+                sink = sink + static_cast<size_t>(op());
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+            perOp.push_back(static_cast<double>(ns) / static_cast<double>(r.iterations));
+        }
+        std::sort(perOp.begin(), perOp.end());
+        r.medianNs = perOp[perOp.size() / 2];
+        r.minNs = perOp.front();
+        r.maxNs = perOp.back();
+        write(r);
+    }
+
+private:
+    void write(const BenchResult& r) {
+        std::ostringstream line;
+        line.setf(std::ios::fixed);
+        line.precision(1);
+        if (options.json)
+            line << "{\"benchmark\":\"" << r.name << "\",\"iterations\":" << r.iterations
+                 << ",\"median_ns\":" << r.medianNs << ",\"min_ns\":" << r.minNs
+                 << ",\"max_ns\":" << r.maxNs << "}\n";
+        else
+            line << r.name << ',' << r.iterations << ',' << r.medianNs << ',' << r.minNs << ','
+                 << r.maxNs << '\n';
+        out << line.str() << std::flush;
+    }
+
+    const BenchOptions& options;
+    std::ostream& out;
+};
+
+// ---- synthetic layouts ----------------------------------------------------
+
+enum class Layout { OPEN, MAZE, BOXES, DETOUR };
+
+const char* layoutName(Layout layout) {
+    switch (layout) {
+        case Layout::OPEN: return "open";
+        case Layout::MAZE: return "maze";
+        case Layout::BOXES: return "boxes";
+        case Layout::DETOUR: return "detour";
+    }
+    return "unknown";
+}
+
+// Start in the top-left corner, goal in the bottom-right one. The maze is a
+// serpentine of wall columns with alternating gaps, so the only route visits
+// most of the grid; the box layout covers 30% of the cells outside the two
+// corners. The detour layout has two walls across the floor with gaps at
+// opposite ends, so the route doubles back and a flat search floods most of
+// the grid before it finds a short path.
+std::unique_ptr<Grid> makeLayout(Layout layout, int n) {
+    auto grid = std::make_unique<Grid>(n, n);
+    if (layout == Layout::MAZE) {
+        for (int x = 2, k = 0; x < n - 1; x += 4, k++) {
+            if (k % 2 == 0) grid->addWallRange(x, 0, x, n - 2);
+            else grid->addWallRange(x, 1, x, n - 1);
+        }
+    } else if (layout == Layout::DETOUR) {
+        grid->addWallRange(0, n / 3, n - 2, n / 3);
+        grid->addWallRange(1, 2 * n / 3, n - 1, 2 * n / 3);
+    } else if (layout == Layout::BOXES) {
+        std::mt19937 rng(1);
+        std::bernoulli_distribution dense(0.3);
+        grid->reserveBoxes(static_cast<size_t>(n) * n * 3 / 10 + n);
+        for (int y = 0; y < n; y++)
+            for (int x = 0; x < n; x++)
+                if (dense(rng) && (x + y > 4) && (2 * n - 2 - x - y > 4))
+                    grid->placeBox(x, y);
+    }
+    return grid;
+}
+
+void benchPaths(Bench& bench, const BenchOptions& options) {
+    for (int n = 64; n <= options.maxSize; n *= 4) {
+        for (Layout layout : {Layout::OPEN, Layout::MAZE, Layout::BOXES, Layout::DETOUR}) {
+            std::string suffix = std::string("/") + layoutName(layout) + "/" + std::to_string(n);
+            if (!bench.wanted("path/dijkstra" + suffix) && !bench.wanted("path/astar" + suffix) &&
+                !bench.wanted("path/jps" + suffix) && !bench.wanted("path/hpa" + suffix))
+                continue;
+
+            std::unique_ptr<Grid> grid = makeLayout(layout, n);
+            Pos start = {0, 0};
+            Pos goal = {n - 1, n - 1};
+
+            bench.run("path/dijkstra" + suffix, [&] {
+                return computeDijkstraPath(*grid, start.first, start.second, goal.first, goal.second).size();
+            });
+
+            std::vector<Pos> path;
+            // The warm-up call builds the HPA* graph, so only queries are timed
+            for (PlannerKind kind : {PlannerKind::ASTAR, PlannerKind::JPS, PlannerKind::HPA}) {
+                std::unique_ptr<PathPlanner> planner = makePlanner(kind);
+                bench.run(std::string("path/") + plannerKindName(kind) + suffix, [&] {
+                    planner->findPath(*grid, start, goal, path);
+                    return path.size();
+                });
+            }
+        }
+    }
+}
+
+// The lookup Robot::findNearestNonPivotBox makes when nothing was sensed in
+// the plan phase: nearest floor box below the stack cap, not a pivot and not
+// claimed by another robot
+void benchNearestBox(Bench& bench) {
+    const int n = 256;
+    for (int permille : {1, 10, 100}) {
+        std::string name = "nearest_box/256/density_permille=" + std::to_string(permille);
+        if (!bench.wanted(name)) continue;
+
+        Grid grid(n, n);
+        std::mt19937 rng(2);
+        std::uniform_int_distribution<int> cell(0, n - 1);
+        int count = n * n * permille / 1000;
+        grid.reserveBoxes(static_cast<size_t>(count));
+        for (int placed = 0; placed < count;) {
+            int x = cell(rng), y = cell(rng);
+            if (grid.hasBox(x, y)) continue;
+            grid.placeBox(x, y);
+            placed++;
+        }
+
+        // A few boxes are claimed by peers, as in a busy run
+        std::vector<BoxHandle> claimed;
+        for (size_t i = 0; i < 8 && i < grid.boxStore().size(); i++)
+            claimed.push_back(grid.boxStore().handleAt(i * grid.boxStore().size() / 8));
+
+        BoxFilter filter;
+        filter.maxStack = 5;
+        filter.skipPivots = true;
+        filter.accept = [&](BoxHandle handle, const Box&) {
+            return std::find(claimed.begin(), claimed.end(), handle) == claimed.end();
+        };
+
+        std::vector<Pos> queries(1024);
+        for (Pos& q : queries) q = {cell(rng), cell(rng)};
+
+        std::vector<BoxHandle> nearest;
+        size_t next = 0;
+        bench.run(name, [&] {
+            const Pos& q = queries[next++ % queries.size()];
+            return grid.boxIndex().nearest(q.first, q.second, 1, filter, nearest);
+        });
+    }
+}
+
+// Answers every message with an INFORM on the same conversation
+class EchoAgent : public Agent {
+public:
+    using Agent::Agent;
+    int received = 0;
+
+    void receive(const acl::ACLMessage& msg) override {
+        received++;
+        if (msg.performative == acl::Performative::INFORM) return;
+        acl::ACLMessage reply(acl::Performative::INFORM, id, msg.sender, acl::Availability{true},
+                              acl::Language::SL, acl::Ontology::WAREHOUSE, acl::Protocol::FIPA_CONTRACT_NET,
+                              msg.conversationId);
+        send(msg.sender, reply);
+    }
+    void handleResponse(const acl::ACLMessage&) override {}
+};
+
+void benchMessaging(Bench& bench) {
+    // Request out on one delivery phase, reply back on the next
+    if (bench.wanted("acl/request_reply")) {
+        AgentRegistry registry;
+        EchoAgent a("A", registry), b("B", registry);
+        acl::ConversationId conv = 0;
+        bench.run("acl/request_reply", [&] {
+            a.sendRequest(b.getId(), acl::BoxQuery{1, 2}, ++conv);
+            registry.deliverMessages();
+            registry.deliverMessages();
+            return a.received;
+        });
+    }
+
+    // A call for proposals to every agent and all the answers
+    for (int agents : {8, 64}) {
+        std::string name = "acl/broadcast_replies/agents=" + std::to_string(agents);
+        if (!bench.wanted(name)) continue;
+
+        AgentRegistry registry;
+        std::vector<std::unique_ptr<EchoAgent>> all;
+        for (int i = 0; i < agents; i++)
+            all.push_back(std::make_unique<EchoAgent>("Agent" + std::to_string(i), registry));
+
+        acl::ConversationId conv = 0;
+        bench.run(name, [&] {
+            acl::ACLMessage cfp(acl::Performative::CFP, all[0]->getId(), acl::NO_AGENT, acl::BoxQuery{1, 2},
+                                acl::Language::SL, acl::Ontology::WAREHOUSE, acl::Protocol::FIPA_CONTRACT_NET,
+                                ++conv);
+            all[0]->broadcast(cfp);
+            registry.deliverMessages();
+            registry.deliverMessages();
+            return all[0]->received;
+        });
+    }
+}
+
+void benchStacking(Bench& bench) {
+    if (bench.wanted("box/merge")) {
+        Box pivot(0, 0), carried(1, 0);
+        bench.run("box/merge", [&] {
+            pivot.stackSize = 1;
+            pivot.merge(carried);
+            return pivot.stackSize;
+        });
+    }
+
+    // What Robot::tryPickup and tryStack do to the grid for one delivery:
+    // lift a box off the floor and merge it into the pivot stack
+    if (bench.wanted("grid/pick_and_stack")) {
+        Grid grid(64, 64);
+        grid.placeBox(10, 10);
+        BoxHandle pivot = grid.boxAt(10, 10);
+        bench.run("grid/pick_and_stack", [&] {
+            grid.placeBox(11, 10);
+            BoxHandle carried = grid.takeBox(11, 10);
+            grid.stackBox(10, 10, carried);
+            Box* stack = grid.box(pivot);
+            int height = stack->stackSize;
+            stack->stackSize = 1;
+            return height;
+        });
+    }
+}
+
+// Whole runs, setup included, at fixed seeds
+void benchSimulations(Bench& bench) {
+    struct Macro {
+        const char* name;
+        int size, robots, boxes;
+        AssignMode assign;
+        ReplanMode replan;
+        bool cooperative;
+    };
+    const Macro macros[] = {
+        {"sim/negotiate/30x30/r5/b17", 30, 5, 17, AssignMode::NEGOTIATE, ReplanMode::ON_TARGET, false},
+        {"sim/negotiate/60x60/r20/b100", 60, 20, 100, AssignMode::NEGOTIATE, ReplanMode::ON_TARGET, false},
+        {"sim/incremental/60x60/r10/b60", 60, 10, 60, AssignMode::NEGOTIATE, ReplanMode::INCREMENTAL, false},
+        {"sim/auction/120x120/r40/b400", 120, 40, 400, AssignMode::AUCTION, ReplanMode::ON_TARGET, false},
+        {"sim/cooperative/30x30/r8/b17", 30, 8, 17, AssignMode::NEGOTIATE, ReplanMode::ON_TARGET, true},
+    };
+
+    for (const Macro& m : macros) {
+        if (!bench.wanted(m.name)) continue;
+
+        ScenarioConfig config;
+        config.rows = config.cols = m.size;
+        config.robotCount = m.robots;
+        config.boxCount = m.boxes;
+        config.walls = {{m.size / 3, m.size / 3, m.size / 2, m.size / 2}};
+        config.seed = 1;
+        config.seedGiven = true;
+        config.assign = m.assign;
+        config.replan = m.replan;
+        config.cooperative = m.cooperative;
+        config.maxTicks = 100000;
+
+        bench.run(m.name, [&] {
+            SimulationContext sim(config);
+            std::string error;
+            if (!sim.populate(error)) {
+                std::cerr << "ERROR: " << m.name << ": " << error << "\n";
+                std::exit(2);
+            }
+            return sim.run().ticks;
+        });
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    std::string error;
+
+    if (!parseBenchArgs(argc, argv, options, error)) {
+        std::cerr << "ERROR: " << error << "\n";
+        printBenchUsage(std::cerr, argv[0]);
+        return 2;
+    }
+
+    std::ofstream file;
+    if (!options.outputPath.empty()) {
+        file.open(options.outputPath);
+        if (!file) {
+            std::cerr << "ERROR: cannot write " << options.outputPath << "\n";
+            return 2;
+        }
+    }
+
+    // Only errors: the benchmarks should time the work, not the log
+    logging::start(std::cerr, logging::Level::ERROR);
+
+    Bench bench(options, file.is_open() ? static_cast<std::ostream&>(file) : std::cout);
+    benchPaths(bench, options);
+    benchNearestBox(bench);
+    benchMessaging(bench);
+    benchStacking(bench);
+    benchSimulations(bench);
+
+    logging::stop();
+    return 0;
+}
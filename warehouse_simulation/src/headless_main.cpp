@@ -0,0 +1,81 @@
+// Headless entry point: no window, no frame limit. Steps the robots as fast
+// as the CPU allows and prints a one-line JSON summary when the run ends.
+#include "Log.hpp"
+#include "Scenario.hpp"
+#include "SimulationContext.hpp"
+
+#include <fstream>
+#include <iostream>
+
+int main(int argc, char** argv) {
+    ScenarioConfig config;
+    std::string error;
+
+    if (!parseScenarioArgs(argc, argv, config, error)) {
+        std::cerr << "ERROR: " << error << "\n";
+        printScenarioUsage(std::cerr, argv[0]);
+        return 2;
+    }
+    if (!config.offscreenPath.empty()) {
+        std::cerr << "ERROR: --offscreen is only supported by the windowed binary\n";
+        return 2;
+    }
+
+    // The per-robot log shares stdout with the summary, so it is stopped
+    // (and drained) before the summary is written
+    if (config.verbose)
+        logging::start(std::cout, logging::Level::TRACE);
+    else
+        logging::start(std::cerr, logging::Level::WARN);
+
+    std::ofstream metricsFile;
+    if (!config.metricsPath.empty()) {
+        metricsFile.open(config.metricsPath);
+        if (!metricsFile) {
+            logging::stop();
+            std::cerr << "ERROR: cannot write " << config.metricsPath << "\n";
+            return 2;
+        }
+    }
+
+    std::ofstream traceFile;
+    if (!config.tracePath.empty()) {
+        traceFile.open(config.tracePath, std::ios::binary);
+        if (!traceFile) {
+            logging::stop();
+            std::cerr << "ERROR: cannot write " << config.tracePath << "\n";
+            return 2;
+        }
+    }
+
+    SimulationContext sim(config);
+    if (!sim.populate(error)) {
+        logging::stop();
+        std::cerr << "ERROR: " << error << "\n";
+        return 2;
+    }
+
+    TraceRecorder recorder(traceFile, static_cast<int>(config.traceKeyframes));
+    if (traceFile.is_open())
+        sim.attachTrace(&recorder);
+
+    long long dumpedAt = -1;
+    RunResult result = sim.run([&] {
+        if (metricsFile.is_open() && config.metricsEvery > 0 && sim.getTick() % config.metricsEvery == 0) {
+            sim.getMetrics().writeJson(metricsFile, sim.getTick());
+            dumpedAt = sim.getTick();
+        }
+    });
+
+    if (traceFile.is_open())
+        recorder.finish();
+
+    // The final dump, unless the last periodic one already covered this tick
+    if (metricsFile.is_open() && dumpedAt != sim.getTick())
+        sim.getMetrics().writeJson(metricsFile, sim.getTick());
+
+    logging::stop();
+    writeResultJson(std::cout, config, result);
+
+    return result.completed ? 0 : 1;
+}
@@ -0,0 +1,49 @@
+// Layout converter: turns a hand-written text layout into the binary form
+// that loads without parsing, or a binary layout back into text.
+#include "Layout.hpp"
+
+#include <iostream>
+#include <string>
+
+namespace {
+
+void printLayoutUsage(std::ostream& out, const char* program) {
+    out << "Usage: " << program << " [--text] IN OUT\n"
+        << "  Reads a text or binary layout and writes it as binary (default) or, with --text, as a text map\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool text = false;
+    std::string in, out;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--text") {
+            text = true;
+        } else if (arg.rfind("--", 0) == 0 || !out.empty()) {
+            std::cerr << "ERROR: unknown option " << arg << "\n";
+            printLayoutUsage(std::cerr, argv[0]);
+            return 2;
+        } else {
+            (in.empty() ? in : out) = arg;
+        }
+    }
+    if (out.empty()) {
+        std::cerr << "ERROR: expected an input and an output file\n";
+        printLayoutUsage(std::cerr, argv[0]);
+        return 2;
+    }
+
+    std::string error;
+    std::shared_ptr<const Layout> layout = loadLayout(in, error);
+    if (!layout || !(text ? saveLayoutText(*layout, out, error) : saveLayoutBinary(*layout, out, error))) {
+        std::cerr << "ERROR: " << error << "\n";
+        return 2;
+    }
+
+    std::cout << "{\"rows\":" << layout->rows << ",\"cols\":" << layout->cols << ",\"boxes\":" << layout->boxCount()
+              << ",\"docks\":" << layout->dockCount() << "}\n";
+    return 0;
+}
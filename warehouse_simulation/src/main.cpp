@@ -1,78 +1,136 @@
 #include <SFML/Graphics.hpp>
-#include "Grid.hpp"
-#include "Robot.hpp"
-#include "SharedMemory.hpp"
-
+#include "GridRenderer.hpp"
+#include "Log.hpp"
+#include "Scenario.hpp"
+#include "SimulationContext.hpp"
+#include "Snapshot.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
-#include <random>
-#include <set>
+#include <thread>
 
-bool onReached(){
-    std::cout << "Reached target!" << std::endl;
-    return true;
-}
+namespace {
 
-// Helper to get a random empty cell on the grid
-std::pair<int,int> getRandomEmptyCell(const Grid& grid, const std::set<std::pair<int,int>>& occupied, std::mt19937& rng) {
-    std::uniform_int_distribution<int> distRow(0, grid.rows - 1);
-    std::uniform_int_distribution<int> distCol(0, grid.cols - 1);
+using Clock = std::chrono::steady_clock;
 
-    while (true) {
-        int r = distRow(rng);
-        int c = distCol(rng);
+const int FRAME_RATE = 60;
 
-        // Check cell not wall, no box, and not occupied
-        if (grid.cells[r][c].type != WALL && grid.cells[r][c].box == nullptr && occupied.count({c,r}) == 0)
-            return {c, r};
-    }
+// Largest cell (up to 20 px) that fits the grid in width x height pixels
+int fitCellSize(const ScenarioConfig& config, unsigned width, unsigned height) {
+    int fit = std::min(static_cast<int>(width) / config.cols, static_cast<int>(height) / config.rows);
+    return std::max(1, std::min(20, fit));
 }
 
-int main() {
+// Simulation thread: steps at the configured rate (or flat out) and
+// publishes a snapshot after every tick. It never waits for the viewer.
+void simulate(SimulationContext& sim, SnapshotPublisher& publisher, const std::atomic<bool>& stop) {
+    const ScenarioConfig& config = sim.getConfig();
+    auto period = std::chrono::nanoseconds(config.tickRate > 0 ? 1000000000 / config.tickRate : 0);
+    auto next = Clock::now();
+
+    while (!stop.load(std::memory_order_relaxed) && !sim.allRobotsIdle() && !sim.stalled() &&
+           (config.maxTicks == 0 || sim.getTick() < config.maxTicks)) {
+        sim.step();
+        publisher.publish();
+        if (config.tickRate > 0) {
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+    }
+    publisher.publish(true);
+}
 
-    const int rows = 30, cols = 30, cellSize = 20;
+// How far robots are between the last two ticks: the snapshot's age in tick
+// periods. Uncapped runs tick faster than any frame rate, so they snap.
+float interpolation(const Snapshot& s, int tickRate) {
+    if (tickRate <= 0 || s.finished) return 1.0f;
+    float ticks = std::chrono::duration<float>(Clock::now() - s.publishedAt).count() * tickRate;
+    return std::min(1.0f, ticks);
+}
 
-    sf::RenderWindow window(
-        sf::VideoMode(cols * cellSize, rows * cellSize),
-        "Warehouse Robots"
-    );
+// Renders into a texture instead of a window (works under a software GL
+// such as Mesa's llvmpipe) and saves the last frame
+int runOffscreen(SimulationContext& sim, GridRenderer& renderer, unsigned width, unsigned height) {
+    const ScenarioConfig& config = sim.getConfig();
+    sf::RenderTexture canvas;
+    if (!canvas.create(width, height)) {
+        logging::stop();
+        std::cerr << "ERROR: cannot create a " << width << "x" << height << " offscreen target\n";
+        return 2;
+    }
 
-    Grid grid(rows, cols);
+    SnapshotPublisher publisher(sim);
+    std::atomic<bool> stop{false};
+    std::thread simThread(simulate, std::ref(sim), std::ref(publisher), std::cref(stop));
+
+    auto frame = std::chrono::nanoseconds(1000000000 / FRAME_RATE);
+    auto next = Clock::now();
+    do {
+        publisher.fetch();
+        canvas.clear();
+        renderer.draw(canvas, publisher.latest(), interpolation(publisher.latest(), config.tickRate));
+        canvas.display();
+        next += frame;
+        std::this_thread::sleep_until(next);
+    } while (!publisher.latest().finished);
+
+    simThread.join();
+    logging::stop();
+
+    if (!canvas.getTexture().copyToImage().saveToFile(config.offscreenPath)) {
+        std::cerr << "ERROR: cannot write " << config.offscreenPath << "\n";
+        return 2;
+    }
+    writeResultJson(std::cout, config, sim.result());
+    return 0;
+}
 
-    // Add walls first
-    grid.addWallRange(10, 10, 15, 15);
+} // namespace
 
-    std::random_device rd;
-    std::mt19937 rng(rd());
+int main(int argc, char** argv) {
 
-    std::set<std::pair<int,int>> occupiedCells;
+    ScenarioConfig config;
+    std::string error;
 
-    // Spawn 17 boxes at random empty cells
-    for (int i = 0; i < 17; i++) {
-        auto [bx, by] = getRandomEmptyCell(grid, occupiedCells, rng);
-        grid.placeBox(bx, by);
-        occupiedCells.insert({bx, by});
+    if (!parseScenarioArgs(argc, argv, config, error)) {
+        std::cerr << "ERROR: " << error << "\n";
+        printScenarioUsage(std::cerr, argv[0]);
+        return 2;
     }
 
-    // Spawn 3 robots at random empty cells (no overlap with boxes or walls or other robots)
-    Robot robots[] = {
-        Robot("Robot1", 0, 0),
-        Robot("Robot2", 0, 0),
-        Robot("Robot3", 0, 0),
-        Robot("Robot4", 0, 0),
-        Robot("Robot5", 0, 0),
-    };
-
-    for (auto& r : robots) {
-        auto [rx, ry] = getRandomEmptyCell(grid, occupiedCells, rng);
-        r.x = rx;
-        r.y = ry;
-        occupiedCells.insert({rx, ry});
-        grid.addRobot(&r);
+    logging::start(std::cout, config.verbose ? logging::Level::TRACE : logging::Level::INFO);
+
+    SimulationContext sim(config);
+    if (!sim.populate(error)) {
+        logging::stop();
+        std::cerr << "ERROR: " << error << "\n";
+        return 2;
     }
 
-    window.setFramerateLimit(20);
+    // On screen the window fits the desktop; offscreen the texture stays
+    // within what any GL driver can allocate
+    sf::VideoMode desktop = sf::VideoMode::getDesktopMode();
+    const int cellSize = config.offscreenPath.empty()
+                             ? fitCellSize(config, desktop.width * 9 / 10, desktop.height * 9 / 10)
+                             : fitCellSize(config, 4096, 4096);
+    const unsigned width = static_cast<unsigned>(config.cols * cellSize);
+    const unsigned height = static_cast<unsigned>(config.rows * cellSize);
+    GridRenderer renderer(sim.getGrid(), cellSize);
+
+    if (!config.offscreenPath.empty())
+        return runOffscreen(sim, renderer, width, height);
 
-    SharedMemory::get().startTimer();
+    sf::RenderWindow window(sf::VideoMode(width, height), "Warehouse Robots");
+
+    window.setFramerateLimit(FRAME_RATE);
+
+    // The simulation runs on its own thread; this one only draws the newest
+    // snapshot, so a slow frame never holds up a tick or the other way round
+    SnapshotPublisher publisher(sim);
+    std::atomic<bool> stop{false};
+    std::thread simThread(simulate, std::ref(sim), std::ref(publisher), std::cref(stop));
 
     while (window.isOpen()) {
         sf::Event e;
@@ -81,34 +139,34 @@ int main() {
                 window.close();
         }
 
-        // Update all robots
-        for (auto& r : robots)
-            r.update(grid);
-
-        bool allExploringNoTargets = true;
-        for (const auto& r : robots) {
-            if (r.state != EXPLORING || r.targetBox != nullptr) {
-                allExploringNoTargets = false;
-                break;
-            }
-        }
-
-        if (allExploringNoTargets) {
-            auto elapsedMs = SharedMemory::get().getElapsedTimeMs();
-            std::cout << "All robots are exploring with no target boxes.\n";
-            std::cout << "Simulation ended after " << elapsedMs << " milliseconds.\n";
-            std::cout << "Total number of movements " << SharedMemory::get().getMovementCount() << ".\n";
-            window.close();
-            break;
-        }
-
+        publisher.fetch();
+        const Snapshot& snapshot = publisher.latest();
 
         // Render
         window.clear();
-        grid.draw(window, cellSize);
+        renderer.draw(window, snapshot, interpolation(snapshot, config.tickRate));
 
         window.display();
+
+        if (snapshot.finished)
+            break;
     }
 
+    stop.store(true, std::memory_order_relaxed);
+    simThread.join();
+
+    if (sim.allRobotsIdle()) {
+        auto elapsedMs = sim.getMemory().getElapsedTimeMs();
+        logging::stop();
+        std::cout << "All robots are exploring with no target boxes.\n";
+        std::cout << "Simulation ended after " << elapsedMs << " milliseconds.\n";
+        std::cout << "Total number of movements " << sim.getMemory().getMovementCount() << ".\n";
+    } else if (sim.stalled()) {
+        logging::stop();
+        std::cout << "No box has moved for a long time; the robots are stuck. Stopped at tick "
+                  << sim.getTick() << ".\n";
+    }
+
+    logging::stop();
     return 0;
-}
\ No newline at end of file
+}
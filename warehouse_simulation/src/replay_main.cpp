@@ -0,0 +1,187 @@
+// Trace replayer: rebuilds the ticks of a run recorded with
+// `warehouse_headless --trace FILE` without running any planning or
+// negotiation, to inspect what happened at a given tick or over a window.
+#include "Trace.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace {
+
+struct ReplayOptions {
+    std::string path;
+    long long tick = -1;            // -1 -> no state dump
+    bool map = false;
+    long long logFrom = -1, logTo = -1;
+    bool bench = false;
+};
+
+void printReplayUsage(std::ostream& out, const char* program) {
+    out << "Usage: " << program << " TRACE [options]\n"
+        << "  --tick N        print the robots (and, with --map, the floor) at the end of tick N\n"
+        << "  --map           draw the floor: # wall, 1-5 stack height, P pivot, R robot, C carrying robot\n"
+        << "  --log A,B       print the events and messages of ticks A to B\n"
+        << "  --bench         time a full replay and random seeks\n";
+}
+
+bool parseTick(const char* text, long long& out) {
+    if (!text) return false;
+    char* end = nullptr;
+    out = std::strtoll(text, &end, 10);
+    return end != text && (*end == '\0' || *end == ',') && out >= 0;
+}
+
+bool parseReplayArgs(int argc, char** argv, ReplayOptions& options, std::string& error) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (arg == "--map") {
+            options.map = true;
+        } else if (arg == "--bench") {
+            options.bench = true;
+        } else if (arg == "--tick") {
+            if (!parseTick(value, options.tick)) {
+                error = "--tick expects a non-negative integer";
+                return false;
+            }
+            i++;
+        } else if (arg == "--log") {
+            const char* comma = value ? std::strchr(value, ',') : nullptr;
+            if (!comma || !parseTick(value, options.logFrom) || !parseTick(comma + 1, options.logTo) ||
+                options.logTo < options.logFrom) {
+                error = "--log expects A,B with A <= B";
+                return false;
+            }
+            i++;
+        } else if (arg.rfind("--", 0) == 0 || !options.path.empty()) {
+            error = "unknown option " + arg;
+            return false;
+        } else {
+            options.path = arg;
+        }
+    }
+    if (options.path.empty()) {
+        error = "no trace given";
+        return false;
+    }
+    return true;
+}
+
+const char* eventName(TraceEventKind kind) {
+    switch (kind) {
+        case TraceEventKind::PICK: return "pick";
+        case TraceEventKind::STACK: return "stack";
+        case TraceEventKind::PIVOT_ON: return "pivot-on";
+        case TraceEventKind::PIVOT_OFF: return "pivot-off";
+    }
+    return "unknown";
+}
+
+void printState(std::ostream& out, const TraceState& s, bool map) {
+    out << "tick " << s.tick << "\n";
+    for (size_t i = 0; i < s.robots.size(); i++)
+        out << "  robot #" << i << " at (" << s.robots[i].x << "," << s.robots[i].y << ")"
+            << (s.robots[i].carrying ? " carrying" : "") << "\n";
+    if (!map) return;
+
+    std::vector<std::string> rows(s.rows, std::string(s.cols, '.'));
+    for (int y = 0; y < s.rows; y++) {
+        for (int x = 0; x < s.cols; x++) {
+            size_t i = static_cast<size_t>(y) * s.cols + x;
+            if (s.walls[i]) rows[y][x] = '#';
+            else if (s.cells[i].pivot) rows[y][x] = 'P';
+            else if (s.cells[i].height) rows[y][x] = static_cast<char>('0' + s.cells[i].height);
+        }
+    }
+    for (const TraceRobot& r : s.robots)
+        if (r.y >= 0 && r.y < s.rows && r.x >= 0 && r.x < s.cols)
+            rows[r.y][r.x] = r.carrying ? 'C' : 'R';
+    for (const std::string& row : rows)
+        out << row << "\n";
+}
+
+void printTick(std::ostream& out, const TraceState& s) {
+    for (const TraceEvent& e : s.events) {
+        out << s.tick << " " << eventName(e.kind);
+        if (e.robot != acl::NO_AGENT) out << " robot #" << e.robot;
+        out << " (" << e.x << "," << e.y << ")";
+        if (e.kind == TraceEventKind::STACK) out << " height " << e.height;
+        out << "\n";
+    }
+    for (const acl::ACLMessage& m : s.messages) {
+        out << s.tick << " " << acl::performativeName(m.performative) << " #" << m.sender << " -> ";
+        if (m.receiver == acl::NO_AGENT) out << "all";
+        else out << "#" << m.receiver;
+        out << " conv " << (m.conversationId >> 32) << ":" << (m.conversationId & 0xffffffffu);
+        std::string content = acl::contentToString(m.content);
+        if (!content.empty()) out << " \"" << content << "\"";
+        out << "\n";
+    }
+}
+
+void bench(TraceReplayer& replay) {
+    using Clock = std::chrono::steady_clock;
+
+    auto start = Clock::now();
+    replay.seek(0);
+    long long ticks = 0;
+    while (replay.next()) ticks++;
+    double fullMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    const int seeks = 1000;
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<long long> pick(0, replay.lastTick());
+    start = Clock::now();
+    for (int i = 0; i < seeks; i++)
+        replay.seek(pick(rng));
+    double seekUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / seeks;
+
+    std::cout << "{\"replayed_ticks\":" << ticks << ",\"replay_ms\":" << fullMs
+              << ",\"ticks_per_second\":" << (fullMs > 0 ? ticks / fullMs * 1000.0 : 0.0)
+              << ",\"mean_seek_us\":" << seekUs << "}\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    ReplayOptions options;
+    std::string error;
+
+    if (!parseReplayArgs(argc, argv, options, error)) {
+        std::cerr << "ERROR: " << error << "\n";
+        printReplayUsage(std::cerr, argv[0]);
+        return 2;
+    }
+
+    TraceReplayer replay;
+    if (!replay.open(options.path, error)) {
+        std::cerr << "ERROR: " << error << "\n";
+        return 2;
+    }
+
+    const TraceState& s = replay.state();
+    std::cout << "{\"rows\":" << s.rows << ",\"cols\":" << s.cols << ",\"robots\":" << s.robots.size()
+              << ",\"seed\":" << replay.seed() << ",\"ticks\":" << replay.lastTick()
+              << ",\"keyframe_interval\":" << replay.keyframeInterval() << "}\n";
+
+    if (options.logFrom >= 0) {
+        replay.seek(options.logFrom);
+        do {
+            printTick(std::cout, replay.state());
+        } while (replay.state().tick < options.logTo && replay.next());
+    }
+
+    if (options.tick >= 0) {
+        replay.seek(options.tick);
+        printState(std::cout, replay.state(), options.map);
+    }
+
+    if (options.bench)
+        bench(replay);
+    return 0;
+}
@@ -1,96 +1,81 @@
 #include "utils.hpp"
+#include "Log.hpp"
 
+#include <algorithm>
 #include <vector>
-#include <optional>
 #include <queue>
-#include <iostream>
 #include <limits>
 
 using Pos = std::pair<int, int>;
 
-std::vector<Pos> computeDijkstraPath(const Grid& grid, int startX, int startY, int targetX, int targetY) {
+std::vector<Pos> computeDijkstraPath(const Grid& grid, int startX, int startY, int targetX, int targetY,
+                                     int* expanded) {
     const int INF = std::numeric_limits<int>::max();
 
     // Check if start and target are within bounds
-    if (startX < 0 || startX >= grid.cols || startY < 0 || startY >= grid.rows ||
-        targetX < 0 || targetX >= grid.cols || targetY < 0 || targetY >= grid.rows) {
-        std::cout << "Invalid start or target coordinates.\n";
+    if (!grid.inBounds(startX, startY) || !grid.inBounds(targetX, targetY)) {
+        WLOG_WARN(PLANNER, "invalid start ({},{}) or target ({},{})", startX, startY, targetX, targetY);
         return {};
     }
 
-    // Directions (4-way)
-    const int dirs[4][2] = {
-        {1, 0}, {-1, 0}, {0, 1}, {0, -1}
-    };
+    // Flat arrays over the padded index space; the wall border means
+    // neighbours never need a bounds check
+    const int* offsets = grid.neighborOffsets();
+    const int start = grid.index(startX, startY);
+    const int target = grid.index(targetX, targetY);
 
-    std::vector<std::vector<int>> dist(grid.rows, std::vector<int>(grid.cols, INF));
-    std::vector<std::vector<std::optional<Pos>>> parent(grid.rows, std::vector<std::optional<Pos>>(grid.cols, std::nullopt));
+    std::vector<int> dist(grid.cellCount(), INF);
+    std::vector<int> parent(grid.cellCount(), -1);
 
-    auto cmp = [&](const std::pair<int, Pos>& a, const std::pair<int, Pos>& b) {
+    using Entry = std::pair<int, int>;  // (distance, cell index)
+    auto cmp = [](const Entry& a, const Entry& b) {
         return a.first > b.first;  // min-heap by distance
     };
-    std::priority_queue<std::pair<int, Pos>, std::vector<std::pair<int, Pos>>, decltype(cmp)> pq(cmp);
+    std::priority_queue<Entry, std::vector<Entry>, decltype(cmp)> pq(cmp);
 
-    dist[startY][startX] = 0;
-    pq.push({0, {startX, startY}});
+    dist[start] = 0;
+    pq.push({0, start});
 
     while (!pq.empty()) {
-        auto [curDist, curPos] = pq.top();
+        auto [curDist, cur] = pq.top();
         pq.pop();
 
-        int cx = curPos.first;
-        int cy = curPos.second;
-
-        if (curDist > dist[cy][cx])
+        if (curDist > dist[cur])
             continue;
+        if (expanded) ++*expanded;
 
-        if (cx == targetX && cy == targetY)
+        if (cur == target)
             break;
 
-        for (auto& d : dirs) {
-            int nx = cx + d[0];
-            int ny = cy + d[1];
-
-            // Check bounds
-            if (ny < 0 || ny >= grid.rows || nx < 0 || nx >= grid.cols)
-                continue;
+        for (int i = 0; i < 4; i++) {
+            int next = cur + offsets[i];
 
             // Allow target cell even if it has a box, but not walls or other boxes in path
-            bool isTargetCell = (nx == targetX && ny == targetY);
-
-            if (grid.cells[ny][nx].type == WALL)
+            if (grid.isWall(next))
                 continue;
 
-            if (grid.cells[ny][nx].box != nullptr && !isTargetCell)
+            if (grid.hasBox(next) && next != target)
                 continue;
 
             int ndist = curDist + 1;
-            if (ndist < dist[ny][nx]) {
-                dist[ny][nx] = ndist;
-                parent[ny][nx] = {cx, cy};
-                pq.push({ndist, {nx, ny}});
+            if (ndist < dist[next]) {
+                dist[next] = ndist;
+                parent[next] = cur;
+                pq.push({ndist, next});
             }
         }
     }
 
-    if (dist[targetY][targetX] == INF) {
-        std::cout << "Target unreachable\n";
+    if (dist[target] == INF) {
+        WLOG_DEBUG(PLANNER, "target ({},{}) unreachable", targetX, targetY);
         return {};
     }
 
     std::vector<Pos> path;
-    Pos cur = {targetX, targetY};
-    while (cur != Pos{startX, startY}) {
-        path.push_back(cur);
-        auto p = parent[cur.second][cur.first];
-        if (!p.has_value()) {
-            std::cout << "No parent found for (" << cur.first << "," << cur.second << "), path incomplete.\n";
-            return {};
-        }
-        cur = p.value();
-    }
+    for (int cur = target; cur != start; cur = parent[cur])
+        path.push_back({grid.xOf(cur), grid.yOf(cur)});
     std::reverse(path.begin(), path.end());
 
-    std::cout << "Dijkstra finished. Distance to target: " << dist[targetY][targetX] << std::endl;
+    WLOG_TRACE(PLANNER, "dijkstra finished, distance to target: {}", dist[target]);
     return path;
-}
\ No newline at end of file
+}